@@ -0,0 +1,338 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+// Micro and macro benchmarks of the simulation, no window is opened. Usage:
+// ColonySimulatorBench [--filter text] [--repeat n] [--out path]
+// Every run starts from the same seed, the results are written as JSON to compare builds
+
+#include "Economy.hpp"
+#include "Human.hpp"
+#include "Island.hpp"
+#include "Jobs.hpp"
+#include "Json.hpp"
+#include "MemoryStats.hpp"
+#include "Pathfinding.hpp"
+#include "Perlin.hpp"
+#include "Progress.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
+#include "Settings.hpp"
+#include "Ship.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <raymath.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BENCH_SEED 7
+#define BENCH_REPEAT 5
+#define BENCH_OUT "bench.json"
+
+std::string filter;
+int repeat = BENCH_REPEAT;
+Json results = Json::array_t();
+// Nothing reads it, a result stored here keeps the compiler from dropping the work behind it
+volatile double sink = 0;
+
+void DoNotOptimize(double value) { sink = value; }
+
+// Runs setup and then body repeat times, only body is timed. items is the amount of work done by
+// one run of body, used for the throughput
+void Benchmark(const std::string& name, double items, const std::function<void()>& body,
+               const std::function<void()>& setup = nullptr)
+{
+    if (name.find(filter) == std::string::npos) return;
+
+    std::vector<double> times;
+    for (int i = 0; i < repeat; i++)
+    {
+        if (setup) setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    double mean = 0;
+    for (double time: times)
+    {
+        mean += time;
+    }
+    mean /= times.size();
+    double median = times[times.size() / 2];
+
+    Json result;
+    result.format = JsonFormat::Inline;
+    result["name"] = name;
+    result["repeat"] = repeat;
+    result["minMs"] = times[0];
+    result["medianMs"] = median;
+    result["meanMs"] = mean;
+    result["itemsPerSecond"] = items / (median / 1000);
+    results.push_back(result);
+
+    std::cout << name << ": median " << median << " ms, min " << times[0] << " ms, "
+              << items / (median / 1000) << " items/s\n";
+}
+
+void BuildWorld(Vector2 size, float stepSize)
+{
+    CancelPathMap();
+    mapSize = size;
+    perlinSeed = BENCH_SEED;
+    SeedRandom(perlinSeed);
+    SetThreadRng(&GetRng(RngStream::World));
+    woodTotal = ironTotal = peopleTotal = 0;
+    simulationTime = 0;
+    std::atomic<float> percent = 0;
+    BuildIslands(percent, stepSize);
+    ships.Clear();
+    ResetSimulationEvents();
+}
+
+void WaitForPathMap()
+{
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        while (!IsPathMapReady(i))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Colonizes every island and spreads count humans over them
+void Populate(size_t count)
+{
+    people.clear();
+    RebuildPeopleIndex();
+    for (auto& island: islands)
+    {
+        island.colonized = true;
+        island.peopleCount = 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        Island& island = islands[i % islands.size()];
+        island.peopleCount++;
+        AddHuman(island.GetRandomPoint(), island.index);
+    }
+    populationHeap.Build();
+}
+
+void BenchPerlin()
+{
+    const int size = 1000;
+    Benchmark("perlin/GetPerlin", size * size,
+              []
+              {
+                  float sum = 0;
+                  for (int y = 0; y < size; y++)
+                  {
+                      for (int x = 0; x < size; x++)
+                      {
+                          sum += GetPerlin({x * 0.3f - 150, y * 0.3f - 150});
+                      }
+                  }
+                  DoNotOptimize(sum);
+              });
+    Benchmark("perlin/Perlin", size * size,
+              []
+              {
+                  float sum = 0;
+                  for (int y = 0; y < size; y++)
+                  {
+                      for (int x = 0; x < size; x++)
+                      {
+                          sum += Perlin({x * 0.3f - 150, y * 0.3f - 150});
+                      }
+                  }
+                  DoNotOptimize(sum);
+              });
+}
+
+void BenchBuildIslands()
+{
+    const std::vector<float> sizes = {100, 300, 600};
+    const std::vector<float> steps = {0.1f, 0.25f};
+    for (float size: sizes)
+    {
+        for (float step: steps)
+        {
+            std::string name = "buildIslands/" + std::to_string((int)size) + "/" +
+                               std::to_string(step).substr(0, 4);
+            Benchmark(name, size * size, [size, step] { BuildWorld({size, size}, step); });
+        }
+    }
+}
+
+void BenchPathfinding()
+{
+    BuildWorld({300, 300}, 0.1f);
+    Benchmark("pathMap/GeneratePathMap", islands.size(),
+              []
+              {
+                  GeneratePathMap();
+                  WaitForPathMap();
+              });
+
+    // From every port to a few other islands, like the ships go
+    const int targets = 8;
+    Benchmark("pathMap/GetPath", islands.size() * targets,
+              []
+              {
+                  size_t points = 0;
+                  for (size_t i = 0; i < islands.size(); i++)
+                  {
+                      if (islandPorts[i].empty()) continue;
+                      for (int j = 1; j <= targets; j++)
+                      {
+                          int target = (i + j * 7) % islands.size();
+                          Vector2 port = IntToVector2(islandPorts[i][0]);
+                          points += GetPath(port, target).size();
+                      }
+                  }
+                  DoNotOptimize(points);
+              });
+}
+
+void BenchSaves()
+{
+    BuildWorld({300, 300}, 0.1f);
+    GeneratePathMap();
+    WaitForPathMap();
+
+    const std::vector<size_t> counts = {1000, 10000, 100000};
+    for (size_t count: counts)
+    {
+        Populate(count);
+        currentSlot = 0;
+        SaveToSlot(0);
+        std::string suffix = "/" + std::to_string(count);
+
+        Json json;
+        Benchmark("json/ToString" + suffix, count,
+                  [&json]
+                  {
+                      std::string text = json.ToString();
+                      DoNotOptimize(text.size());
+                  },
+                  [&json] { json = saveSlots[0].ToJSON(); });
+
+        std::string text = saveSlots[0].ToJSON().ToString();
+        Benchmark("json/Parse" + suffix, count,
+                  [&text]
+                  {
+                      Json parsed = Json::Parse(text);
+                      DoNotOptimize(parsed.size());
+                  });
+
+        Benchmark("progress/SaveProgress" + suffix, count, [] { SaveProgress(); });
+        Benchmark("progress/LoadProgress" + suffix, count, [] { LoadProgress(); });
+    }
+    EmptySlot(0);
+    currentSlot = -1;
+}
+
+void BenchSimulation()
+{
+    BuildWorld({300, 300}, 0.1f);
+    Populate(100000);
+
+    const int ticks = 100;
+    // A day away from the game
+    const int offlineTicks = 86400 / GROWTH_PERIOD;
+    Benchmark("economy/CatchUpOffline", islands.size() * offlineTicks,
+              [] { CatchUpOffline(0, offlineTicks); });
+    Benchmark("economy/RunEconomyTicks", islands.size() * ticks,
+              []
+              {
+                  SetEconomyTick(economyTick + ticks);
+                  CatchUpEconomy();
+              },
+              [] { ResetEconomy(0); });
+
+    Benchmark("humans/MovePeople", people.size(), [] { MovePeople(0.016f); });
+}
+
+// Islands run their due ticks whenever the frame budget lets them, the state after some periods
+// has to be the same as when they all run right away
+bool CheckEconomyBudget()
+{
+    const int periods = 20;
+    const double budgets[] = {0, INFINITY};
+    uint64_t hashes[2];
+    for (int i = 0; i < 2; i++)
+    {
+        BuildWorld({300, 300}, 0.1f);
+        Populate(10000);
+        for (int period = 0; period < periods; period++)
+        {
+            // Fewer frames leave more islands behind, so they catch up from different ticks
+            int frames = 1 + period % 8;
+            for (int frame = 1; frame <= frames; frame++)
+            {
+                UpdateEconomy((double)frame / frames, budgets[i]);
+            }
+            SetEconomyTick(economyTick + 1);
+        }
+        CatchUpEconomy();
+        hashes[i] = GetStateHash();
+    }
+    bool same = hashes[0] == hashes[1];
+    std::cout << "check/economyBudget: " << (same ? "ok" : "the state hashes differ") << '\n';
+    return same;
+}
+
+int main(int argc, char** argv)
+{
+    std::string out = std::filesystem::absolute(BENCH_OUT).string();
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter") filter = argv[i + 1];
+        if (arg == "--repeat") repeat = std::max(1, atoi(argv[i + 1]));
+        if (arg == "--out") out = std::filesystem::absolute(argv[i + 1]).string();
+    }
+
+    // Saves are written to a directory of their own, not over the player's ones
+    auto directory = std::filesystem::temp_directory_path() / "ColonySimulatorBench";
+    std::filesystem::create_directories(directory);
+    std::filesystem::current_path(directory);
+
+    InitJobs();
+    memoryStatsEnabled = true;
+
+    bool passed = CheckEconomyBudget();
+    BenchPerlin();
+    BenchBuildIslands();
+    BenchPathfinding();
+    BenchSaves();
+    BenchSimulation();
+
+    CancelPathMap();
+    ShutdownJobs();
+    UpdateMemoryStats();
+    PrintMemoryStats();
+
+    Json json;
+    json["seed"] = BENCH_SEED;
+    json["workers"] = GetWorkerCount();
+#ifdef __VERSION__
+    json["compiler"] = __VERSION__;
+#endif
+    json["checksPassed"] = passed;
+    json["benchmarks"] = results;
+    json["memory"] = MemoryStatsToJSON();
+    json.Save(out);
+    std::cout << "Saved the results to " << out << '\n';
+    return passed ? 0 : 1;
+}
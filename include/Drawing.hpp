@@ -25,6 +25,12 @@ extern Vector2 windowSize;
 
 extern Shader perlinShader;
 
+struct PerlinShaderLocations
+{
+    int scale = -1, resolution = -1, offset = -1, seed = -1, mapSize = -1;
+};
+extern PerlinShaderLocations perlinShaderLocs;
+
 extern Texture lockTexture;
 extern Texture woodTexture;
 extern Texture ironTexture;
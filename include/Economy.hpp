@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Real seconds a frame can spend on the growth ticks of the islands, the rest waits for the next
+// frame
+#define ECONOMY_FRAME_BUDGET 0.002
+// Islands ticked between the budget checks
+#define ECONOMY_SLICE 16
+// Set in the keys of the ticks run for the time the game was closed, so they don't draw the same
+// numbers as the played ones
+#define OFFLINE_TICK_FLAG (1ull << 63)
+
+// Economy of the colonized islands as a struct of arrays, so a tick over all of them is a few
+// flat loops without branches
+struct EconomyBatch
+{
+    std::vector<int> index, wood, woodGrowth, woodMax, iron, peopleCount, peopleMax, taxes;
+    std::vector<int> efficiency, added;
+    std::vector<float> peopleGrowth;
+    std::vector<int64_t> fraction;
+    int64_t woodGained = 0, ironGained = 0;
+
+    // Empties the arrays but keeps their memory
+    void Clear();
+    // Copies the given islands in
+    void Gather(const std::vector<int>& islandIdxs);
+    // Copies them back, places the new humans and updates the totals. The humans are placed by
+    // the island and tick, the tick the islands were brought up to
+    void Scatter(uint64_t tick);
+    // One growth tick of the islands from begin up to end. The efficiency drift is keyed by the
+    // island and the tick
+    void Tick(uint64_t tick, size_t begin, size_t end);
+    // True if the efficiency of island i can't drift anymore
+    bool IsSteady(size_t i) const;
+    // Ticks up to limit island i can run before its population changes. Only valid if it's steady
+    int64_t GetSteadyTicks(size_t i, int64_t limit) const;
+    // Same as that many calls of Tick for island i, in one step
+    void SteadyTicks(size_t i, int64_t ticks);
+};
+
+// Growth ticks before this number are due. Every island runs them in its own frame, see
+// UpdateEconomy, or right before anything reads or changes it
+extern int64_t economyTick;
+
+// Sets every island to have run the ticks before tick
+void ResetEconomy(int64_t tick);
+void SetEconomyTick(int64_t tick);
+// Runs the due ticks of one island, the uncolonized ones just skip them
+void CatchUpEconomy(int islandIdx);
+void CatchUpEconomy();
+bool IsCaughtUp(int islandIdx);
+// True once UpdateEconomy ran every island's due ticks of this period
+bool IsEconomyCaughtUp();
+// Islands get a phase inside GROWTH_PERIOD by their index. phase is the part of the period passed
+// since the last due tick, the islands up to it run their ticks as long as the budget lasts
+void UpdateEconomy(double phase, double budget = ECONOMY_FRAME_BUDGET);
+// Runs ticks growth ticks on every island for the time the game was closed, the first one keyed
+// by firstTick. The steady stretches are skipped
+void CatchUpOffline(uint64_t firstTick, int64_t ticks);
@@ -6,6 +6,8 @@
 
 #include "Json.hpp"
 #include "Utils.hpp"
+#include <cstdint>
+#include <vector>
 typedef struct Vector2 Vector2;
 
 #define MIN_SPEED 0.2f
@@ -18,7 +20,10 @@ struct Human
     Vector2 pos = {0, 0};
     float angle = 0;
     float rotation = 0;
+    Vector2 dir = {1, 0};
     int islandIdx = -1;
+    // Position in islandPeople[islandIdx]
+    uint32_t islandSlot = 0;
     float speed = 0, rotationSpeed = 0;
     int angleMultiplier = 1;
 
@@ -29,10 +34,18 @@ struct Human
         rotationSpeed = GetRandomFloat(MIN_ROT_SPEED, MAX_ROT_SPEED);
     }
 
-    void MoveToTarget(double deltaTime);
+    void SetHeading(int heading);
 
     Json ToJSON();
     static Human LoadJSON(Json& json);
 };
 
 extern std::vector<Human> people;
+// Indices into people for every island, kept in sync by AddHuman and RemoveIslandPeople
+extern std::vector<std::vector<uint32_t>> islandPeople;
+
+void AddHuman(Vector2 pos, int islandIdx);
+// Removes the last count humans of the island, the last humans of people fill the holes
+void RemoveIslandPeople(int islandIdx, int count);
+void RebuildPeopleIndex();
+void MovePeople(float deltaTime);
@@ -8,6 +8,7 @@
 #include "Json.hpp"
 #include "Pathfinding.hpp"
 #include <atomic>
+#include <cstdint>
 #include <raylib.h>
 #include <vector>
 
@@ -21,6 +22,13 @@ struct Biome
 #define GROWTH_PERIOD 1
 #define DEFAULT_TAXES 67
 
+#define K_WOOD_GET 3
+#define K_IRON_GET 1
+#define K_EFFICIENCY 5
+// One person in the fixed point units of addPeopleFraction
+#define PEOPLE_FRACTION_ONE ((int64_t)1 << 32)
+
+// In every water body the island touches
 #define PORTS_PER_ISLAND 1
 
 struct Island
@@ -29,11 +37,17 @@ struct Island
     float area = 0;
     int woodColonize = 0, ironColonize = 0, woodCount = 0, woodGrowth = 0, woodMax = 0,
         ironCount = 0, peopleCount = 0, peopleMax = 0, futurePeopleCount = 0;
-    float peopleGrowth = 0, addPeopleFraction = 0;
+    float peopleGrowth = 0;
+    // Grown part of the next people in 1 / PEOPLE_FRACTION_ONE people. Fixed point, so adding the
+    // growth of many ticks at once gives the same result as adding it tick by tick
+    int64_t addPeopleFraction = 0;
     bool colonizationInProgress = false;
     bool colonized = false;
     int taxes = DEFAULT_TAXES, efficiency = 50;
     int index = -1;
+    // Simplified coastline and its centroid, not saved, see BuildIslandOutlines
+    std::vector<Vector2> outline;
+    Vector2 center = {0, 0};
 
     Island() = default;
     Island(Vector2 p1, Vector2 p2, float area, int woodColonize, int ironColonize, int woodCount,
@@ -46,19 +60,43 @@ struct Island
     }
 
     Vector2 GetRandomPoint();
-    void Colonize();
-    void SendPeople(int count);
+    // The people come from sourceIdx, the most populated other island if it's -1
+    void Colonize(int sourceIdx = -1);
+    void SendPeople(int count, int sourceIdx = -1);
     void AddPeople(int count);
-    void GrowthTick();
     void DrawStats();
 
     Json ToJSON();
     static Island LoadJSON(Json& json);
+
+  private:
+    int FindSource();
+    void TakePeople(int sourceIdx, int count);
 };
 
 extern std::vector<Biome> biomes;
 extern std::vector<Island> islands;
 
+// Max-heap of island indices by population with the position of every island in it, so the most
+// populated island is found in O(1) and a changed population is updated in O(log n)
+struct PopulationHeap
+{
+    std::vector<int> heap, position;
+
+    void Build();
+    void Update(int islandIdx);
+    // Most populated island other than islandIdx, the lowest index wins ties. -1 if there is none
+    int TopExcept(int islandIdx) const;
+
+  private:
+    bool Before(int a, int b) const;
+    void Swap(size_t i, size_t j);
+    void SiftUp(size_t i);
+    void SiftDown(size_t i);
+};
+
+extern PopulationHeap populationHeap;
+
 #define LAND_START biomes[3].startLevel
 
 extern int woodTotal;
@@ -76,5 +114,7 @@ template <class T1, class T2> struct std::hash<std::pair<T1, T2>>
     }
 };
 
-void BuildIslands(std::atomic<bool>& finished, float stepSize = 0.1f);
-void BuildMap();
+void BuildIslands(std::atomic<float>& loadingPercent, float stepSize = 0.1f);
+// Builds a new map from perlinSeed and starts recording it. A headless build doesn't draw the
+// loading screen
+void BuildMap(bool headless = false);
@@ -0,0 +1,21 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <raylib.h>
+#include <vector>
+
+// Traces the coast of every island with marching squares on the island raster and simplifies it
+// to outlineTolerance. The outlines of the last map are kept, so loading it again is free
+void BuildIslandOutlines();
+
+// Bytes of the kept outlines and of the noise field they're traced on
+size_t GetOutlineMemory();
+
+// Removes the points closer than tolerance to the simplified line, keeps the polygon closed
+std::vector<Vector2> SimplifyOutline(const std::vector<Vector2>& points, float tolerance);
+// Center of mass of the polygon
+Vector2 GetPolygonCentroid(const std::vector<Vector2>& polygon);
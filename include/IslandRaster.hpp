@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "Json.hpp"
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+// Raster cells per world unit
+#define ISLAND_RASTER_RES 2
+
+// Island index + 1 for every cell, 0 for water and islands that are too small
+extern std::vector<uint16_t> islandRaster;
+extern int islandRasterWidth, islandRasterHeight;
+extern Vector2 islandRasterOrigin;
+
+// Land mask cells of every island, island i owns islandCells[islandCellStart[i]] up to
+// islandCells[islandCellStart[i + 1]]
+extern std::vector<uint32_t> islandCells, islandCellStart;
+
+// Allocates an empty raster covering the map
+void ResizeIslandRaster();
+// Labels the land again and matches the parts to the islands by their bounding boxes. Only an
+// approximation, used for saves made before the raster was saved with them
+void RebuildIslandRaster();
+// Fills islandCells from the land mask and the raster
+void BuildIslandCells();
+// Saves the raster as pairs of a value and its run length
+Json IslandRasterToJSON(const std::vector<uint16_t>& raster);
+std::vector<uint16_t> IslandRasterFromJSON(Json& json);
+
+// Index of the island at pos, -1 if there is none
+inline int IslandAt(Vector2 pos)
+{
+    float x = (pos.x - islandRasterOrigin.x) * ISLAND_RASTER_RES;
+    float y = (pos.y - islandRasterOrigin.y) * ISLAND_RASTER_RES;
+    if (x < 0 || y < 0 || x >= islandRasterWidth || y >= islandRasterHeight) return -1;
+    return islandRaster[(int)y * islandRasterWidth + (int)x] - 1;
+}
+
+// Uniform point on the land of the island, false if the cells were built for another map
+bool GetRandomIslandPoint(int islandIdx, Vector2& pos);
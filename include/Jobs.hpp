@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+// Tracks a set of jobs. Waiting on it runs queued jobs instead of blocking
+class JobGroup
+{
+  public:
+    JobGroup() = default;
+    JobGroup(const JobGroup&) = delete;
+    JobGroup& operator=(const JobGroup&) = delete;
+    ~JobGroup() { WaitJobs(); }
+
+    void Run(std::function<void()> job);
+    // Throws the first exception one of the jobs threw
+    void Wait();
+    bool IsDone() const { return pending == 0; }
+
+  private:
+    friend void FinishJob(JobGroup* group, std::exception_ptr error);
+    std::atomic<int> pending{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void WaitJobs();
+};
+
+// 0 workers means one less than the amount of hardware threads
+void InitJobs(int workerCount = 0);
+void ShutdownJobs();
+int GetWorkerCount();
+
+// Calls body(begin, end) for chunks of at most grain elements, the calling thread helps
+void ParallelFor(size_t begin, size_t end, size_t grain,
+                 const std::function<void(size_t, size_t)>& body);
@@ -232,6 +232,8 @@ class Json
     static Json Load(const std::filesystem::path& path);
     static Json Parse(const std::string& json);
     std::string ToString(size_t level = 0) const;
+    // Bytes the children, strings and keys take on the heap, the value itself isn't included
+    size_t MemoryUsage() const;
 
   private:
     static void SkipWhitespace(const std::string& s, size_t& idx);
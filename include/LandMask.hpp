@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+// Mask cells per world unit
+#define LAND_MASK_RES 4
+
+extern std::vector<uint8_t> landMask;
+extern int landMaskWidth, landMaskHeight;
+extern Vector2 landMaskOrigin;
+
+void BuildLandMask();
+
+inline bool IsWalkable(Vector2 pos)
+{
+    float x = (pos.x - landMaskOrigin.x) * LAND_MASK_RES;
+    float y = (pos.y - landMaskOrigin.y) * LAND_MASK_RES;
+    if (x < 0 || y < 0 || x >= landMaskWidth || y >= landMaskHeight) return false;
+    return landMask[(int)y * landMaskWidth + (int)x];
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -14,3 +15,6 @@ extern std::unordered_map<std::string, std::string> labels;
 
 void GetAllLanguages();
 void ReloadLabels();
+// Same as labels[key], but doesn't build a string for the key, so it can be used every frame.
+// Missing labels are empty
+const char* GetLabel(std::string_view key);
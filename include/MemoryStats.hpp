@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "Json.hpp"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Resident bytes of the big containers and of the GPU resources, counted from their sizes. The
+// heap overhead of every allocation isn't included
+enum class MemorySubsystem
+{
+    PathMap,
+    // Points of the routes the ships follow
+    Routes,
+    // Islands with their raster, cells, outlines and the land mask
+    Islands,
+    People,
+    Ships,
+    SaveSlots,
+    // The document of saves.json, only alive during a save or a load
+    Json,
+    Font,
+    Textures,
+    Count
+};
+
+template <typename T> size_t MemoryOf(const std::vector<T>& vector)
+{
+    return vector.capacity() * sizeof(T);
+}
+
+template <typename T> size_t MemoryOf(const std::vector<std::vector<T>>& vector)
+{
+    size_t bytes = vector.capacity() * sizeof(std::vector<T>);
+    for (auto& inner: vector)
+    {
+        bytes += MemoryOf(inner);
+    }
+    return bytes;
+}
+
+// Nodes hold the pair with the next pointer and the cached hash
+template <typename K, typename V> size_t MemoryOf(const std::unordered_map<K, V>& map)
+{
+    return map.size() * (sizeof(std::pair<const K, V>) + 2 * sizeof(void*)) +
+           map.bucket_count() * sizeof(void*);
+}
+
+// Short strings are stored inline by the common standard libraries
+inline size_t MemoryOf(const std::string& string)
+{
+    return string.capacity() > 15 ? string.capacity() + 1 : 0;
+}
+
+// Saves and loads only measure their memory while this is set, it's set by the profiler overlay,
+// the replays and the benchmarks
+extern bool memoryStatsEnabled;
+
+// Measures every subsystem again and raises the peaks
+void UpdateMemoryStats();
+// For the memory that only exists for a moment, like the Json document of a save. It counts
+// towards the peaks, UpdateMemoryStats doesn't touch it
+void SetMemoryUsage(MemorySubsystem subsystem, size_t bytes);
+// MemorySubsystem::Count gives the total of all of them
+size_t GetMemoryUsage(MemorySubsystem subsystem);
+size_t GetPeakMemoryUsage(MemorySubsystem subsystem);
+const char* GetMemorySubsystemName(MemorySubsystem subsystem);
+// Current and peak bytes of every subsystem
+Json MemoryStatsToJSON();
+void PrintMemoryStats();
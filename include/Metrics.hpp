@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+
+#define METRICS_PATH "metrics.jsonl"
+// Once the file grows past this many bytes it is moved to METRICS_OLD_PATH and started over
+#define METRICS_FILE_LIMIT (16 << 20)
+#define METRICS_OLD_PATH "metrics.old.jsonl"
+
+enum class Metric
+{
+    // Counters, every thread counts on its own and they are summed when written
+    Frames,
+    // Counted by the callers of GetPerlin, once per chunk of a grid
+    NoiseEvaluations,
+    RouteCacheHits,
+    RouteCacheMisses,
+    ShipsLaunched,
+    GrowthTicks,
+    SaveBytes,
+    // Only counted in profiler builds
+    Allocations,
+    AllocatedBytes,
+    // Gauges, the last value set is written
+    People,
+    Ships,
+    ColonizedIslands,
+    ScheduledEvents,
+    Count
+};
+
+#define METRIC_FIRST_GAUGE Metric::People
+
+void AddMetric(Metric metric, int64_t amount = 1);
+void SetMetric(Metric metric, int64_t value);
+// The total of a counter or the value of a gauge
+int64_t GetMetric(Metric metric);
+// Appends a line to METRICS_PATH once metricsInterval seconds of time have passed since the last
+// one. Counters are written as the amount since the last line
+void UpdateMetrics(double time);
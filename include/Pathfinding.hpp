@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 typedef struct Vector2 Vector2;
@@ -11,7 +13,51 @@ typedef struct Vector2 Vector2;
 using Path = std::vector<Vector2>;
 using ParentMap = std::vector<int>;
 
+// Routes are never changed after they are built, so the ships leaving the same port for the same
+// island share one. The points of all routes are stored one after another in routePoints, with
+// the distance from the start of their route in routeDistances
+using RouteId = uint32_t;
+#define NO_ROUTE UINT32_MAX
+struct Route
+{
+    uint32_t first = 0, count = 0;
+    float length = 0;
+    // Bounding box of the points
+    float minX = 0, minY = 0, maxX = 0, maxY = 0;
+};
+extern std::vector<Route> routes;
+extern std::vector<Vector2> routePoints;
+extern std::vector<float> routeDistances;
 extern std::vector<ParentMap> pathMap;
+// Water cells next to the coast of every island where its ships leave and arrive
+extern std::vector<std::vector<int>> islandPorts;
+// Connected water body of every cell, -1 for land
+extern std::vector<int> seaRegions;
+// Sorted water bodies every island touches, it has ports in all of them
+extern std::vector<std::vector<int>> islandSeaRegions;
 
+// Cell of the path maps a position falls in and back
+int Vector2ToInt(Vector2 v);
+Vector2 IntToVector2(int val);
+
+// Builds the path maps in the background, the game can continue while they aren't ready
 void GeneratePathMap();
+// Stops the background jobs of the last GeneratePathMap call and waits for them
+void CancelPathMap();
+bool IsPathMapReady(int islandIdx);
+// False if the islands share no water body, so no ship can get there
+bool IsReachable(int sourceIslandIdx, int targetIslandIdx);
 Path GetPath(Vector2 startPos, int targetIslandIdx);
+// True if the segment only crosses water cells
+bool IsLineOfSight(Vector2 from, Vector2 to);
+// Keeps only the points where the path has to turn to stay on water
+Path SmoothPath(const Path& path);
+// Smoothed path from the port of the source island closest to the target. Handles are valid until
+// the next GeneratePathMap call. NO_ROUTE if no port of the source shares water with the target
+RouteId GetRoute(int sourceIslandIdx, int targetIslandIdx);
+// Point of the route distance units away from its start. flip is 1 if it heads right there, -1
+// if it heads left
+Vector2 GetRoutePoint(RouteId id, float distance, int* flip = nullptr);
+// Bytes of the path maps that are ready with the ports, regions and land cells they're built from
+size_t GetPathMapMemory();
+size_t GetRouteMemory();
@@ -6,6 +6,8 @@
 
 typedef struct Vector2 Vector2;
 
+// A single octave of the noise
+float Perlin(Vector2 pos);
 float GetPerlin(Vector2 v);
 bool InsideMap(Vector2 pos);
 
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+// Scoped timers and counters, only built with the ENABLE_PROFILER CMake option. Without it the
+// macros below expand to nothing, their arguments aren't even evaluated. The profiler build also
+// replaces the global operator new to count the allocations of every frame and scope
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+
+// Frames kept for the frame time percentiles
+#define PROFILER_HISTORY 600
+// Events kept in one trace, the rest are dropped
+#define PROFILER_TRACE_LIMIT 1000000
+#define PROFILER_TRACE_PATH "trace.json"
+// Threads with their own allocation counters, the rest share the last ones
+#define PROFILER_MAX_THREADS 64
+
+struct AllocationCount
+{
+    uint64_t count = 0, bytes = 0;
+};
+
+// Allocations made by the calling thread since it started
+AllocationCount GetThreadAllocations();
+// Allocations made by all the threads since the start of the game
+AllocationCount GetTotalAllocations();
+
+// Returns the id of the section with the given name, creating it if needed
+int GetProfileSection(const char* name, bool counter = false);
+
+// Adds the time between its construction and destruction and the allocations made by its thread
+// meanwhile to a section. Works on any thread
+struct ProfileScope
+{
+    int section;
+    double start;
+    AllocationCount allocations;
+
+    explicit ProfileScope(int section);
+    ~ProfileScope();
+};
+
+void ProfileCount(int section, double value);
+// Closes the frame: keeps its time and allocations and handles the overlay keys. F3 shows the
+// overlay, F4 starts a trace and saves it to PROFILER_TRACE_PATH when pressed again
+void ProfileFrame();
+void DrawProfiler();
+// Chrome trace format, open it in chrome://tracing or Perfetto
+void SaveProfilerTrace(const char* path);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)                                                                        \
+    static const int PROFILE_CONCAT(profileSection, __LINE__) = GetProfileSection(name);          \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileSection, __LINE__))
+#define PROFILE_COUNT(name, value)                                                                 \
+    do                                                                                             \
+    {                                                                                              \
+        static const int section = GetProfileSection(name, true);                                 \
+        ProfileCount(section, value);                                                              \
+    } while (0)
+#define PROFILE_FRAME() ProfileFrame()
+#define PROFILE_OVERLAY() DrawProfiler()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, value)
+#define PROFILE_FRAME()
+#define PROFILE_OVERLAY()
+
+#endif
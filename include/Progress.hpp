@@ -11,6 +11,9 @@
 #include <vector>
 
 #define MAX_SAVE_SLOTS 7
+// Autosaves go to a file of their own, so leaving a game without saving still goes back to the
+// last save. It's only loaded when it's newer than its slot, e.g. after a crash
+#define AUTOSAVE_PATH "autosave.json"
 
 struct SaveSlot
 {
@@ -18,10 +21,14 @@ struct SaveSlot
     std::string name = "Empty slot";
     std::vector<Island> islands;
     std::vector<Human> people;
-    std::vector<ParentMap> pathMap;
     std::vector<Ship> ships;
     int woodTotal = 0, ironTotal = 0, peopleTotal = 0;
     Vector2 mapSize{300, 300};
+    // Wall-clock time of the last save in seconds, 0 if unknown
+    double saveTime = 0;
+    double simulationTime = 0;
+    // Empty for saves made before it was kept, see IslandRaster.hpp
+    std::vector<uint16_t> islandRaster;
 
     Json ToJSON();
     void LoadJSON(Json& json);
@@ -35,3 +42,5 @@ void LoadFromSlot(int idx);
 void EmptySlot(int idx);
 void SaveProgress();
 void LoadProgress();
+// Copies the current slot right away and writes it to AUTOSAVE_PATH on a job
+void Autosave();
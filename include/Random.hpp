@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+
+// xoshiro128** generator
+struct Rng
+{
+    uint32_t state[4] = {1, 2, 3, 4};
+    uint64_t seed = 0;
+
+    Rng() = default;
+    Rng(uint64_t seed, uint64_t stream);
+
+    uint32_t Next()
+    {
+        uint32_t result = Rotl(state[1] * 5, 7) * 9;
+        uint32_t t = state[1] << 9;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = Rotl(state[3], 11);
+        return result;
+    }
+
+    // [0, 1)
+    float NextFloat() { return (Next() >> 8) * 0x1.0p-24f; }
+    float NextFloat(float a, float b) { return NextFloat() * (b - a) + a; }
+    // [0, n)
+    int NextInt(int n) { return n <= 0 ? 0 : (int)(((uint64_t)Next() * (uint32_t)n) >> 32); }
+
+    // Independent generator derived from this one's seed, doesn't advance this one
+    Rng Split(uint64_t stream) const { return Rng(seed, stream); }
+
+  private:
+    static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+};
+
+enum class RngStream
+{
+    Main,
+    World,
+    Movement,
+    Economy,
+    Ships,
+    Count
+};
+
+// Resets every stream. Worlds are reseeded from their slot seed, so runs can be reproduced
+void SeedRandom(uint64_t seed);
+uint64_t GetRandomSeed();
+// The seeds suggested for new worlds come from a generator SeedRandom doesn't reset, so they
+// don't follow from the seed of the world loaded last
+void SeedWorldSeeds(uint64_t seed);
+int GetNewWorldSeed();
+
+// Streams used by the main thread
+Rng& GetRng(RngStream stream);
+// Generator for a worker or a chunk of entities, split from the current seed
+Rng MakeRng(RngStream stream, uint64_t chunk);
+
+// The generator GetRandomFloat() uses on the calling thread. Threads without one set get their
+// own stream, which is only reproducible if the thread calls SetThreadRng() first
+Rng& GetThreadRng();
+// Returns the previous generator so it can be restored
+Rng* SetThreadRng(Rng* rng);
+
+// Counter-based number for a key and a counter. Nothing is advanced, so the results don't depend
+// on the order they are asked for in
+uint32_t GetRandomAt(RngStream stream, uint64_t key, uint64_t counter);
+inline int GetRandomIntAt(RngStream stream, uint64_t key, uint64_t counter, int n)
+{
+    return n <= 0 ? 0 : (int)(((uint64_t)GetRandomAt(stream, key, counter) * (uint32_t)n) >> 32);
+}
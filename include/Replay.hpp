@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include "Json.hpp"
+#include <cstdint>
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+// With recording enabled every new map is recorded here, it's overwritten by the next one
+#define RECORDING_PATH "recording.json"
+// Simulated seconds per step of a replay
+#define REPLAY_STEP (1.0 / 60)
+// Steps between the memory measurements of a replay
+#define REPLAY_MEMORY_INTERVAL 600
+
+enum class ReplayActionType
+{
+    Colonize,
+    SendPeople,
+    Taxes,
+    // A ship that left, ships wait for path maps for a time that depends on the machine
+    Ship
+};
+
+struct ReplayAction
+{
+    double time = 0;
+    ReplayActionType type = ReplayActionType::Colonize;
+    // The island clicked or changed, the source for ships
+    int island = 0;
+    // Taxes, the target for ships or the island the people were sent from
+    int value = 0;
+    int people = 0;
+
+    Json ToJSON();
+    static ReplayAction LoadJSON(Json& json);
+};
+
+// A map from its seed and size and everything the player did on it by simulated time
+struct Recording
+{
+    int seed = 0;
+    Vector2 mapSize = {0, 0};
+    double endTime = 0;
+    std::vector<ReplayAction> actions;
+
+    Json ToJSON();
+    static Recording LoadJSON(Json& json);
+};
+
+// Recording is off unless the game is started with --record
+void EnableRecording();
+// Starts recording the map that was just built
+void StartRecording();
+void StopRecording();
+void RecordAction(ReplayActionType type, int island, int value = 0, int people = 0);
+bool IsReplaying();
+// Plays a recording without a window with steps of step simulated seconds and prints the hash of
+// the final state with the time every phase took and the memory of every subsystem. The report
+// is also saved to out if it's given
+int RunReplay(const std::string& path, double step = REPLAY_STEP, const std::string& out = "");
+// Hash of the economy, the islands, the ships and the human positions. The positions depend on the
+// step, so only replays with the same step give the same hash
+uint64_t GetStateHash();
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Wheel slots per simulated second
+#define SCHEDULER_RESOLUTION 64
+#define SCHEDULER_LEVELS 4
+// Slots of every level, one bit of the occupancy mask each
+#define SCHEDULER_SLOTS 64
+#define SCHEDULER_SLOT_BITS 6
+
+struct ScheduledEvent
+{
+    double time = 0;
+    // Events with the same time fire in the order they were scheduled
+    uint64_t sequence = 0;
+    void (*fire)(int64_t data) = nullptr;
+    int64_t data = 0;
+};
+
+// Hierarchical timer wheel. Level 0 has a slot for every 1 / SCHEDULER_RESOLUTION seconds, a slot
+// of every next level covers a whole turn of the level below and is moved down when its turn
+// comes. Events further away than the last level wait in an overflow list. Advancing jumps
+// between the occupied slots, so its cost depends on the events that fire, not on the time passed
+class Scheduler
+{
+  public:
+    // Drops every event and restarts the wheel at time
+    void Reset(double time);
+    void Schedule(double time, void (*fire)(int64_t data), int64_t data = 0);
+    // Fires every event up to time in order. clock is set to the time of every event before it
+    // fires and to time at the end
+    void Advance(double& clock, double time);
+    // Time of the earliest event, infinity if there is none
+    double NextTime() const;
+    // The time the running Advance call goes to
+    double Horizon() const { return horizon; }
+    size_t size() const { return count; }
+
+  private:
+    std::vector<ScheduledEvent> slots[SCHEDULER_LEVELS][SCHEDULER_SLOTS];
+    uint64_t occupied[SCHEDULER_LEVELS] = {};
+    std::vector<ScheduledEvent> overflow;
+    // Events of the current slot, a min-heap by time
+    std::vector<ScheduledEvent> due;
+    // Events being moved down by MoveTo. It's swapped with the slots, so the memory goes around
+    // instead of being freed
+    std::vector<ScheduledEvent> moving;
+    int64_t now = 0;
+    uint64_t nextSequence = 0;
+    double horizon = 0;
+    size_t count = 0;
+
+    static int64_t ToTick(double time);
+    void Insert(const ScheduledEvent& event);
+    // Occupancy mask of the slots of the level after the current one
+    uint64_t LaterSlots(int level) const;
+    // First slot start after now with something in it, limit if there is none before it
+    int64_t NextOccupiedTick(int64_t limit) const;
+    void MoveTo(int64_t tick);
+};
+
+extern Scheduler scheduler;
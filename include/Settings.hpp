@@ -8,8 +8,14 @@ typedef struct Vector2 Vector2;
 
 extern bool vsync;
 extern bool showFPS;
+extern bool bakeTerrain;
 extern float panSensitivity;
 extern float wheelSensitivity;
+extern int workerThreads;
+// Max distance in world units between an island outline and its coast
+extern float outlineTolerance;
+// Seconds between the lines of the metrics file, 0 doesn't write it
+extern int metricsInterval;
 extern Vector2 mapSize;
 
 void Save();
@@ -7,28 +7,73 @@
 
 #include "Json.hpp"
 #include "Pathfinding.hpp"
+#include <cstdint>
 #include <raylib.h>
+#include <vector>
 
 #define SHIP_SPEED 25
 
+// A single ship as it is saved. Ships at sea live in the fleet
 struct Ship
 {
     int sourceIndex = 0;
     int targetIndex = 0;
     Vector2 pos{0, 0};
-    int flip = 1;
-    Path path{};
-    Vector2 nextPointDir{0, 0};
-    size_t nextPointIdx = 0;
     int people = 0;
-    bool reached = false;
-
-    Ship() = default;
-    Ship(int sourceIndex, int targetIndex, int peopleCount = 1);
-    void Move(float deltaTime);
 
     Json ToJSON();
     static Ship LoadJSON(Json& json);
 };
 
-extern std::vector<Ship> ships;
+// Ships stored as one array per field, an arrived ship is removed by moving the last one into its
+// place. Ships don't move by themselves: the position is worked out from the time since the
+// departure when it's needed, and the arrival is an event in the scheduler
+struct ShipFleet
+{
+    std::vector<int> sourceIndex, targetIndex, people;
+    std::vector<RouteId> route;
+    // Start of the route, or where a saved ship was
+    std::vector<Vector2> origin;
+    std::vector<double> departure, arrival;
+    // Stable handle of the ship the arrival event refers to
+    std::vector<uint32_t> id;
+
+    size_t size() const { return route.size(); }
+    // Sends a ship along the route from the source island to the target island at simulationTime.
+    // If no route gets there, the people go back to the source and no ship is made
+    void Launch(int sourceIndex, int targetIndex, int people);
+    // Adds a saved ship, ships at sea are only saved as arrived
+    void Add(const Ship& ship);
+    Ship Get(size_t i, double time) const;
+    // flip is 1 if the ship heads right, -1 if it heads left
+    Vector2 GetPosition(size_t i, double time, int* flip = nullptr) const;
+    // Doesn't drop the arrival events, the scheduler is reset along with the fleet
+    void Clear();
+    // Gives the people of the ship to its target and removes the ship
+    void Arrive(uint32_t shipId);
+    size_t MemoryUsage() const;
+
+  private:
+    std::vector<uint32_t> slotOfId, freeIds;
+
+    void Push(double arrival);
+    // Undoes SendPeople for a ship that can't leave
+    void Cancel(int sourceIndex, int targetIndex, int people);
+    void Remove(size_t i);
+};
+
+extern ShipFleet ships;
+
+// A ship that waits for the path map of its target island
+struct ShipRequest
+{
+    int sourceIndex = 0;
+    int targetIndex = 0;
+    int people = 0;
+};
+
+extern std::vector<ShipRequest> shipRequests;
+
+void RequestShip(int sourceIndex, int targetIndex, int peopleCount);
+// Sends the requested ships whose path maps are ready
+void LaunchRequestedShips();
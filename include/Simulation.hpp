@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+
+// Speeds the player can switch between
+#define SIMULATION_SPEEDS {1, 2, 5, 10, 100, 1000}
+// Longest step in seconds people are moved by, so they don't walk through narrow water
+#define SIMULATION_MAX_STEP 0.05f
+// Most simulated seconds people walk in one frame. Only reached at high speeds or below 2 FPS
+#define SIMULATION_MAX_WALK 0.5f
+// Simulated seconds between autosaves
+#define AUTOSAVE_PERIOD 300
+// Real seconds at least between autosaves
+#define AUTOSAVE_MIN_INTERVAL 60
+// Real seconds a due autosave waits for the islands to run their ticks before it runs them at once
+#define AUTOSAVE_MAX_DELAY 5
+
+extern int simulationSpeed;
+// Simulated seconds since the world was created
+extern double simulationTime;
+// Calls of MovePeople since the world was created or loaded, keys the generators of the walk
+extern uint64_t movementStep;
+
+// Starts the growth ticks and autosaves over at simulationTime, the ships schedule their arrivals
+// when they are added to the fleet
+void ResetSimulationEvents();
+// Advances the economy, the ships and the people to endTime
+void StepSimulation(double endTime);
+// Advances the economy, the ships and the people by one frame at the current speed
+void UpdateSimulation(float frameTime);
+// direction is 1 for the next speed and -1 for the previous one
+void ChangeSimulationSpeed(int direction);
@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+
+typedef struct Color Color;
+
+// Size of a baked terrain tile in texels
+#define TERRAIN_TILE_SIZE 256
+// Amount of levels in the tile pyramid. Every level halves the resolution of the previous one
+#define TERRAIN_LEVELS 8
+// World units per texel on the most detailed level
+#define TERRAIN_BASE_TEXEL 0.0625f
+// Time in seconds that can be spent on baking missing tiles every frame
+#define TERRAIN_BAKE_BUDGET 0.004
+// Rows baked between budget checks, a tile that runs out of budget continues on the next frame
+#define TERRAIN_BAKE_ROWS 16
+// Tiles that weren't drawn for the longest time are unloaded above this limit
+#define TERRAIN_MAX_TILES 256
+
+Color GetBiomeColor(float value);
+void DrawTerrain();
+void ClearTerrainCache();
+// Bytes of the baked tiles on the GPU
+size_t GetTerrainMemory();
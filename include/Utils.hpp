@@ -5,15 +5,19 @@
 #pragma once
 
 #include "Drawing.hpp"
+#include "Jobs.hpp"
+#include "Random.hpp"
 #include <atomic>
-#include <cstdlib>
+#include <mutex>
 #include <ostream>
 #include <raygui.h>
 #include <raylib.h>
 #include <string>
-#include <thread>
 
-inline float GetRandomFloat(float a, float b) { return rand() * 1.0f / RAND_MAX * (b - a) + a; }
+// Minimum time between two frames of the loading screen
+#define LOADING_FRAME_TIME (1.0 / 60)
+
+inline float GetRandomFloat(float a, float b) { return GetThreadRng().NextFloat(a, b); }
 
 inline void DrawTextCustom(const char* text, Vector2 pos, int fontSize, Color color)
 {
@@ -26,22 +30,45 @@ inline std::ostream& operator<<(std::ostream& out, const Vector2& vec)
     return out;
 }
 
-template <typename Func, typename... Args>
-void ShowLoadingScreen(bool showProgressbar, Func&& f, Args&&... args)
+// Shared between a loading job and the loading screen drawing it
+struct LoadingState
 {
-    static_assert(
-        std::is_invocable_v<Func, std::string&, float&, std::atomic<bool>&, Args...>,
-        "Function must accept (std::string& label, float& loadingPercent, std::atomic<bool>& finished, ...) as its arguments.");
+    std::atomic<float> percent{0};
+    std::atomic<bool> finished{false};
+
+    void SetLabel(const std::string& text)
+    {
+        std::lock_guard<std::mutex> lock(labelMutex);
+        label = text;
+    }
+    std::string GetLabel()
+    {
+        std::lock_guard<std::mutex> lock(labelMutex);
+        return label;
+    }
 
+  private:
+    std::mutex labelMutex;
     std::string label = "Loading...";
-    float loadingPercent = 0;
+};
 
-    std::atomic<bool> finished(false);
-    std::thread thread(std::forward<Func>(f), std::ref(label), std::ref(loadingPercent),
-                       std::ref(finished), std::forward<Args>(args)...);
-    thread.detach();
+template <typename Func, typename... Args>
+void ShowLoadingScreen(bool showProgressbar, Func&& f, Args&&... args)
+{
+    static_assert(std::is_invocable_v<Func, LoadingState&, Args...>,
+                  "Function must accept (LoadingState& loading, ...) as its arguments.");
 
-    while (!finished)
+    LoadingState loading;
+    JobGroup job;
+    job.Run(
+        [&]
+        {
+            f(loading, args...);
+            loading.finished = true;
+        });
+
+    // A job that threw never finishes, its exception comes out of Wait
+    while (!loading.finished && !job.IsDone())
     {
         BeginDrawing();
 
@@ -50,16 +77,21 @@ void ShowLoadingScreen(bool showProgressbar, Func&& f, Args&&... args)
         UpdateWindowSize();
 
         float fontSize = 24;
-        DrawTextCustom(label.c_str(), {0, windowSize.y - fontSize}, fontSize, WHITE);
+        DrawTextCustom(loading.GetLabel().c_str(), {0, windowSize.y - fontSize}, fontSize, WHITE);
 
         if (showProgressbar)
         {
             Rectangle progressRec = {windowSize.x, windowSize.y, windowSize.x / 2, fontSize};
             progressRec.x -= progressRec.width;
             progressRec.y -= progressRec.height;
-            GuiProgressBar(progressRec, "", "", &loadingPercent, 0, 100);
+            float percent = loading.percent;
+            GuiProgressBar(progressRec, "", "", &percent, 0, 100);
         }
 
         EndDrawing();
+
+        // Don't spin on the render thread when VSync is off
+        WaitTime(LOADING_FRAME_TIME);
     }
+    job.Wait();
 }
@@ -36,6 +36,30 @@ if [ "$1" == "-p" ] || [ "$1" == "--profile" ]; then
     hotspot perf.data
 fi
 
+# Profiler build
+if [ "$1" == "-t" ] || [ "$1" == "--trace" ]; then
+    clear
+    cmake -B build_trace -DCMAKE_BUILD_TYPE=RelWithDebInfo -DENABLE_PROFILER=ON
+    cmake --build build_trace -j$(nproc)
+    ./build_trace/bin/$executable_name
+fi
+
+# Benchmarks
+if [ "$1" == "-b" ] || [ "$1" == "--bench" ]; then
+    clear
+    cmake -B build -DCMAKE_BUILD_TYPE=RelWithDebInfo
+    cmake --build build -j$(nproc) --target ${executable_name}Bench
+    ./build/bin/${executable_name}Bench --out bench.json
+fi
+
+# Headless replay of the last recorded map
+if [ "$1" == "-r" ] || [ "$1" == "--replay" ]; then
+    clear
+    cmake -B build -DCMAKE_BUILD_TYPE=RelWithDebInfo
+    cmake --build build -j$(nproc)
+    ./build/bin/$executable_name --replay ${2:-recording.json} --out replay.json
+fi
+
 # Memory leak build
 if [ "$1" == "-m" ] || [ "$1" == "--memory-leak" ]; then
     clear
@@ -54,5 +78,8 @@ if [ "$1" == "--help" ]; then
     echo "-d, --debug      Compile the debug build and run it with gdb"
     echo "-w, --windows    Compile the Windows build and run it with Wine"
     echo "-p, --profile    Compile the profile build, profile it with perf and display the data with hotspot"
+    echo "-b, --bench      Compile the benchmarks, run them and write the results to bench.json"
+    echo "-r, --replay [FILE]    Compile the release build and replay FILE (recording.json by default) without a window"
+    echo "-t, --trace      Compile the build with the profiler overlay (F3) and trace export (F4) and run it"
     echo "-m, --memory-leak    Compile the memory leak build and run it"
 fi
@@ -8,8 +8,12 @@
 #include "Drawing/MainMenu.hpp"
 #include "Drawing/PauseMenu.hpp"
 #include "Island.hpp"
+#include "Metrics.hpp"
 #include "Perlin.hpp"
+#include "Profiler.hpp"
 #include "Settings.hpp"
+#include "Simulation.hpp"
+#include "Terrain.hpp"
 #include <ctime>
 #include <raygui.h>
 #include <raylib.h>
@@ -24,6 +28,7 @@ double timer = 0;
 bool lastVsync = vsync;
 
 Shader perlinShader;
+PerlinShaderLocations perlinShaderLocs;
 
 Texture lockTexture;
 Texture woodTexture;
@@ -74,6 +79,11 @@ void InitGPU()
     myFont = LoadFontEx("resources/fonts/JetBrainsMono-Bold.ttf", 512, codepoints, codepointCount);
 
     perlinShader = LoadShader(0, "resources/shaders/Perlin.fs");
+    perlinShaderLocs.scale = GetShaderLocation(perlinShader, "uScale");
+    perlinShaderLocs.resolution = GetShaderLocation(perlinShader, "uResolution");
+    perlinShaderLocs.offset = GetShaderLocation(perlinShader, "uOffset");
+    perlinShaderLocs.seed = GetShaderLocation(perlinShader, "uSeed");
+    perlinShaderLocs.mapSize = GetShaderLocation(perlinShader, "uMapSize");
 
     int biomeCount = (int)biomes.size();
     SetShaderValue(perlinShader, GetShaderLocation(perlinShader, "uBiomeCount"), &biomeCount,
@@ -105,6 +115,10 @@ void InitGPU()
 
 void DrawFrame()
 {
+    PROFILE_FRAME();
+    AddMetric(Metric::Frames);
+    UpdateMetrics(GetTime());
+
     if (IsWindowMinimized())
     {
         if (currentMenu == Menu::Game) currentMenu = Menu::Pause;
@@ -114,6 +128,8 @@ void DrawFrame()
         return;
     }
 
+    if (currentMenu == Menu::Game) UpdateSimulation(GetFrameTime());
+
     BeginDrawing();
 
     ClearBackground(BLACK);
@@ -136,6 +152,8 @@ void DrawFrame()
         break;
     }
 
+    PROFILE_OVERLAY();
+
     EndDrawing();
 
     if (currentMenu == Menu::Game) ProcessPlayerInput(GetFrameTime());
@@ -152,6 +170,7 @@ void DrawFrame()
 
 void FreeResources()
 {
+    ClearTerrainCache();
     UnloadShader(perlinShader);
 
     UnloadTexture(lockTexture);
@@ -7,9 +7,15 @@
 #include "Drawing.hpp"
 #include "Human.hpp"
 #include "Island.hpp"
+#include "IslandRaster.hpp"
+#include "Languages.hpp"
+#include "Metrics.hpp"
 #include "Perlin.hpp"
+#include "Profiler.hpp"
 #include "Settings.hpp"
 #include "Ship.hpp"
+#include "Simulation.hpp"
+#include "Terrain.hpp"
 #include "UI.hpp"
 #include "raylib.h"
 #include <algorithm>
@@ -18,12 +24,29 @@
 #include <raymath.h>
 #include <vector>
 
-double growthTimer = 0;
 Vector2 lastMousePosition = GetMousePosition();
 Vector2 mousePressedStart = GetMousePosition();
 
 void OpenGameMenu() { currentMenu = Menu::Game; }
 
+void DrawTooltip(const char* text, Vector2 pos)
+{
+    float fontSize = 24;
+    DrawRectangleRounded(
+        {pos.x - 3, pos.y - 3, MeasureTextEx(myFont, text, fontSize, myFontSpacing).x + 6, 30},
+        0.25f, 16, {0, 0, 0, 127});
+    DrawTextCustom(text, pos, fontSize, WHITE);
+}
+
+void DrawIslandOutline(const Island& island, float thickness, Color color)
+{
+    for (size_t i = 0, j = island.outline.size() - 1; i < island.outline.size(); j = i++)
+    {
+        DrawLineEx(GlslToRaylib(island.outline[j]), GlslToRaylib(island.outline[i]), thickness,
+                   color);
+    }
+}
+
 void DrawResources()
 {
     // Constants
@@ -52,7 +75,7 @@ void DrawResources()
     DrawTextureEx(woodTexture, offset, 0, woodScale, WHITE);
     {
         Vector2 textOffset = GetTextOffset(woodTexture, woodScale);
-        DrawTextCustom(std::to_string(woodTotal).c_str(), textOffset, textScale, WHITE);
+        DrawTextCustom(TextFormat("%d", woodTotal), textOffset, textScale, WHITE);
     }
     offset.y += woodTexture.height * woodScale + margin;
 
@@ -60,7 +83,7 @@ void DrawResources()
     DrawTextureEx(ironTexture, offset, 0, ironScale, WHITE);
     {
         Vector2 textOffset = GetTextOffset(ironTexture, ironScale);
-        DrawTextCustom(std::to_string(ironTotal).c_str(), textOffset, textScale, WHITE);
+        DrawTextCustom(TextFormat("%d", ironTotal), textOffset, textScale, WHITE);
     }
     offset.y += ironTexture.height * ironScale + margin;
 
@@ -69,7 +92,7 @@ void DrawResources()
                   humanScale, WHITE);
     {
         Vector2 textOffset = GetTextOffset(humanTexture, humanScale);
-        DrawTextCustom(std::to_string(peopleTotal).c_str(), textOffset, textScale, WHITE);
+        DrawTextCustom(TextFormat("%d", peopleTotal), textOffset, textScale, WHITE);
     }
     offset.y += humanTexture.height * humanScale + margin;
 }
@@ -77,101 +100,134 @@ void DrawResources()
 void UpdateDynamicShaderValues()
 {
     float scale = perlinScale;
-    SetShaderValue(perlinShader, GetShaderLocation(perlinShader, "uScale"), &scale,
-                   SHADER_UNIFORM_FLOAT);
+    SetShaderValue(perlinShader, perlinShaderLocs.scale, &scale, SHADER_UNIFORM_FLOAT);
 
     windowSize = {(float)GetRenderWidth(), (float)GetRenderHeight()};
-    SetShaderValue(perlinShader, GetShaderLocation(perlinShader, "uResolution"),
-                   (float*)&windowSize, SHADER_UNIFORM_VEC2);
-    windowSize /= GetWindowScaleDPI();
-
-    SetShaderValue(perlinShader, GetShaderLocation(perlinShader, "uOffset"), (float*)&perlinOffset,
+    SetShaderValue(perlinShader, perlinShaderLocs.resolution, (float*)&windowSize,
                    SHADER_UNIFORM_VEC2);
+    windowSize /= GetWindowScaleDPI();
 
-    SetShaderValue(perlinShader, GetShaderLocation(perlinShader, "uMapSize"), (float*)&mapSize,
+    SetShaderValue(perlinShader, perlinShaderLocs.offset, (float*)&perlinOffset,
                    SHADER_UNIFORM_VEC2);
+    SetShaderValue(perlinShader, perlinShaderLocs.seed, &perlinSeed, SHADER_UNIFORM_INT);
+    SetShaderValue(perlinShader, perlinShaderLocs.mapSize, (float*)&mapSize, SHADER_UNIFORM_VEC2);
 }
 
 void DrawGameMenu()
 {
-    UpdateDynamicShaderValues();
-
     // Draw map
-    BeginShaderMode(perlinShader);
-    DrawRectangle(0, 0, windowSize.x, windowSize.y, WHITE);
-    EndShaderMode();
-
-    // Draw people
-    for (auto& human: people)
     {
-        if (currentMenu == Menu::Game) human.MoveToTarget(GetFrameTime());
-        float scale = 0.0005f / perlinScale;
-        Vector2 pos = GlslToRaylib(human.pos);
-        DrawTexturePro(humanTexture, {0, 0, humanTexture.width * 1.0f, humanTexture.height * 1.0f},
-                       {pos.x, pos.y, humanTexture.width * scale, humanTexture.height * scale},
-                       {humanTexture.width * scale / 2.0f, humanTexture.height * scale},
-                       human.angle, WHITE);
+        PROFILE_SCOPE("Terrain");
+        if (bakeTerrain)
+            DrawTerrain();
+        else
+        {
+            UpdateDynamicShaderValues();
+            BeginShaderMode(perlinShader);
+            DrawRectangle(0, 0, windowSize.x, windowSize.y, WHITE);
+            EndShaderMode();
+        }
     }
 
-    // Remove ships that reached their target
-    for (auto it = ships.begin(); it != ships.end();)
+    // Draw people
     {
-        if (it->reached)
+        PROFILE_SCOPE("Humans");
+        PROFILE_COUNT("Human count", people.size());
+        for (auto& human: people)
         {
-            islands[it->targetIndex].AddPeople(it->people);
-            it = ships.erase(it);
+            float scale = 0.0005f / perlinScale;
+            Vector2 pos = GlslToRaylib(human.pos);
+            DrawTexturePro(humanTexture,
+                           {0, 0, humanTexture.width * 1.0f, humanTexture.height * 1.0f},
+                           {pos.x, pos.y, humanTexture.width * scale, humanTexture.height * scale},
+                           {humanTexture.width * scale / 2.0f, humanTexture.height * scale},
+                           human.angle, WHITE);
         }
-        else
-        it++;
     }
 
-    // Draw ships
-    for (auto& ship: ships)
+    // Draw ships. Only the ships on a visible route are placed
     {
-        if (currentMenu == Menu::Game) ship.Move(GetFrameTime());
-        float scale = 0.01f / perlinScale;
-        Vector2 pos = GlslToRaylib(ship.pos);
-        DrawTexturePro(shipTexture,
-                       {0, 0, ship.flip * shipTexture.width * 1.0f, shipTexture.height * 1.0f},
-                       {pos.x, pos.y, shipTexture.width * scale, shipTexture.height * scale},
-                       {shipTexture.width * scale / 2.0f, shipTexture.height * scale}, 0, WHITE);
-        // DrawRectangle(pos.x - 10, pos.y - 20, 20, 20, Color{127, 127, 127, 127});
+        PROFILE_SCOPE("Ships");
+        PROFILE_COUNT("Ship count", ships.size());
+        Vector2 corner1 = RaylibToGlsl({0, 0}), corner2 = RaylibToGlsl(windowSize);
+        Vector2 viewMin = {fminf(corner1.x, corner2.x), fminf(corner1.y, corner2.y)};
+        Vector2 viewMax = {fmaxf(corner1.x, corner2.x), fmaxf(corner1.y, corner2.y)};
+        for (size_t i = 0; i < ships.size(); i++)
+        {
+            if (ships.route[i] != NO_ROUTE)
+            {
+                const Route& route = routes[ships.route[i]];
+                if (route.maxX < viewMin.x || route.minX > viewMax.x || route.maxY < viewMin.y ||
+                    route.minY > viewMax.y)
+                    continue;
+            }
+
+            float scale = 0.01f / perlinScale;
+            int flip = 1;
+            Vector2 pos = GlslToRaylib(ships.GetPosition(i, simulationTime, &flip));
+            DrawTexturePro(shipTexture,
+                           {0, 0, flip * shipTexture.width * 1.0f, shipTexture.height * 1.0f},
+                           {pos.x, pos.y, shipTexture.width * scale, shipTexture.height * scale},
+                           {shipTexture.width * scale / 2.0f, shipTexture.height * scale}, 0,
+                           WHITE);
+            // DrawRectangle(pos.x - 10, pos.y - 20, 20, 20, Color{127, 127, 127, 127});
+        }
     }
 
     // Draw debug ship path lines
-    // for (auto& ship: ships)
+    // for (size_t i = 0; i < ships.size(); i++)
     // {
-    //     Vector2 lastPoint;
-    //     if (!ship.path.empty()) lastPoint = ship.path[0];
+    //     if (ships.route[i] == NO_ROUTE) continue;
+    //     const Route& route = routes[ships.route[i]];
+    //     Vector2 lastPoint = routePoints[route.first];
     //     int counter = 0;
-    //     for (auto& point: ship.path)
+    //     for (uint32_t j = route.first; j < route.first + route.count; j++)
     //     {
-    //         DrawLineEx(GlslToRaylib(lastPoint), GlslToRaylib(point), 3,
-    //                    ColorLerp(RED, BLUE, counter * 1.0f / ship.path.size()));
-    //         lastPoint = point;
+    //         DrawLineEx(GlslToRaylib(lastPoint), GlslToRaylib(routePoints[j]), 3,
+    //                    ColorLerp(RED, BLUE, counter * 1.0f / route.count));
+    //         lastPoint = routePoints[j];
     //         counter++;
     //     }
     // }
   
-    for (auto& island: islands)
+    // Outline the colonized islands and the one under the cursor
     {
-        island.DrawStats();
+        PROFILE_SCOPE("Island stats");
+        int hoveredIdx = IslandAt(RaylibToGlsl(GetMousePosition()));
+        for (auto& island: islands)
+        {
+            if (island.index == hoveredIdx)
+                DrawIslandOutline(island, 3, YELLOW);
+            else if (island.colonized)
+                DrawIslandOutline(island, 2, {255, 255, 255, 127});
+        }
+
+        for (auto& island: islands)
+        {
+            island.DrawStats();
+        }
     }
 
+    PROFILE_SCOPE("UI");
     DrawResources();
 
-    // Joke feature: Snow (obviously)
+    // Tooltips for the island under the cursor
     {
         auto mouse = GetMousePosition();
         auto glslMouse = RaylibToGlsl(mouse);
-        if (GetPerlin(glslMouse) >= biomes[6].startLevel)
+        int islandIdx = IslandAt(glslMouse);
+        if (islandIdx >= 0)
         {
-            float fontSize = 24;
-            const char* text = "Snow (obviously)";
-            DrawRectangleRounded({mouse.x - 3, mouse.y - 3,
-                                  MeasureTextEx(myFont, text, fontSize, myFontSpacing).x + 6, 30},
-                                 0.25f, 16, {0, 0, 0, 127});
-            DrawTextCustom(text, mouse, fontSize, WHITE);
+            const Island& island = islands[islandIdx];
+            DrawTooltip(island.colonized || island.colonizationInProgress
+                            ? GetLabel("Click to send people")
+                            : GetLabel("Click to colonize"),
+                        mouse);
+
+            // Joke feature: Snow (obviously)
+            AddMetric(Metric::NoiseEvaluations);
+            if (GetPerlin(glslMouse) >= biomes[6].startLevel)
+                DrawTooltip("Snow (obviously)", {mouse.x, mouse.y + 32});
         }
     }
 
@@ -180,6 +236,7 @@ void DrawGameMenu()
 
 void ProcessPlayerInput(double deltaTime)
 {
+    PROFILE_SCOPE("Input");
     if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))
         perlinOffset.y += panSensitivity * perlinScale * deltaTime;
     if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S))
@@ -216,22 +273,14 @@ void ProcessPlayerInput(double deltaTime)
         Vector2Distance(GetMousePosition(), mousePressedStart) == 0)
     {
         std::cout << "Mouse pressed!\n";
-        Vector2 v = RaylibToGlsl(GetMousePosition());
-        for (size_t i = 0; i < islands.size(); i++)
+        int i = IslandAt(RaylibToGlsl(GetMousePosition()));
+        if (i >= 0)
         {
-            Vector2 offset{4, 2};
-            Vector2 center = (islands[i].p1 + islands[i].p2) / 2 - offset;
-            const Vector2 boxSize = Vector2{17, 15};
-            if (v.x >= center.x - boxSize.x / 2 && v.x <= center.x + boxSize.x / 2 &&
-                v.y >= center.y - boxSize.y / 2 && v.y <= center.y + boxSize.y / 2)
-            {
-                std::cout << "Clicked on island with id: " << i << '\n';
-                if (islands[i].colonized || islands[i].colonizationInProgress)
-                    islands[i].SendPeople(1);
-                else
-                    islands[i].Colonize();
-                break;
-            }
+            std::cout << "Clicked on island with id: " << i << '\n';
+            if (islands[i].colonized || islands[i].colonizationInProgress)
+                islands[i].SendPeople(1);
+            else
+                islands[i].Colonize();
         }
     }
 
@@ -242,14 +291,8 @@ void ProcessPlayerInput(double deltaTime)
         perlinOffset -= delta * perlinScale * GetWindowScaleDPI();
     }
 
-    if (GetTime() - growthTimer > GROWTH_PERIOD)
-    {
-        growthTimer = GetTime();
-        for (auto& island: islands)
-        {
-            island.GrowthTick();
-        }
-    }
+    if (IsKeyPressed(KEY_PERIOD)) ChangeSimulationSpeed(1);
+    if (IsKeyPressed(KEY_COMMA)) ChangeSimulationSpeed(-1);
 
     lastMousePosition = GetMousePosition();
 }
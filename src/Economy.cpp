@@ -0,0 +1,334 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Economy.hpp"
+#include "Human.hpp"
+#include "Island.hpp"
+#include "Metrics.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <raylib.h>
+
+int64_t economyTick = 0;
+// Next tick of every island
+std::vector<int64_t> islandTicks;
+// Islands before it ran the ticks due in this period
+size_t economyCursor = 0;
+// Kept between the calls, so the ticks of a frame don't allocate
+std::vector<int> dueIslands, colonizedIslands;
+EconomyBatch economyBatch;
+
+void EconomyBatch::Clear()
+{
+    index.clear();
+    wood.clear();
+    woodGrowth.clear();
+    woodMax.clear();
+    iron.clear();
+    peopleCount.clear();
+    peopleMax.clear();
+    taxes.clear();
+    efficiency.clear();
+    peopleGrowth.clear();
+    fraction.clear();
+    added.clear();
+    woodGained = ironGained = 0;
+}
+
+void EconomyBatch::Gather(const std::vector<int>& islandIdxs)
+{
+    for (int idx: islandIdxs)
+    {
+        Island& island = islands[idx];
+        index.push_back(island.index);
+        wood.push_back(island.woodCount);
+        woodGrowth.push_back(island.woodGrowth);
+        woodMax.push_back(island.woodMax);
+        iron.push_back(island.ironCount);
+        peopleCount.push_back(island.peopleCount);
+        peopleMax.push_back(island.peopleMax);
+        taxes.push_back(island.taxes);
+        efficiency.push_back(island.efficiency);
+        peopleGrowth.push_back(island.peopleGrowth);
+        fraction.push_back(island.addPeopleFraction);
+        added.push_back(0);
+    }
+}
+
+void EconomyBatch::Scatter(uint64_t tick)
+{
+    for (size_t i = 0; i < index.size(); i++)
+    {
+        Island& island = islands[index[i]];
+        island.woodCount = wood[i];
+        island.ironCount = iron[i];
+        island.peopleCount = peopleCount[i];
+        island.efficiency = efficiency[i];
+        island.addPeopleFraction = fraction[i];
+        peopleTotal += added[i];
+        if (added[i] == 0) continue;
+        populationHeap.Update(island.index);
+        // Not by the order the islands catch up in, which depends on the frame budget
+        Rng rng = MakeRng(RngStream::Economy, tick ^ (uint64_t)island.index << 40);
+        Rng* lastRng = SetThreadRng(&rng);
+        for (int j = 0; j < added[i]; j++)
+        {
+            AddHuman(island.GetRandomPoint(), island.index);
+        }
+        SetThreadRng(lastRng);
+    }
+    woodTotal += woodGained;
+    ironTotal += ironGained;
+}
+
+// Growth of the population of an island in one tick, in the units of Island::addPeopleFraction
+int64_t GetPeopleGrowth(float peopleGrowth, int peopleCount, int efficiency)
+{
+    return peopleGrowth * sqrt(peopleCount) * efficiency / 100 * PEOPLE_FRACTION_ONE;
+}
+
+void EconomyBatch::Tick(uint64_t tick, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        wood[i] = std::min(wood[i] + woodGrowth[i], woodMax[i]);
+    }
+
+    for (size_t i = begin; i < end; i++)
+    {
+        bool grows = peopleCount[i] >= 2;
+        int64_t next =
+            fraction[i] + GetPeopleGrowth(peopleGrowth[i], peopleCount[i], efficiency[i]);
+        int delta =
+            std::min<int64_t>(next / PEOPLE_FRACTION_ONE, peopleMax[i] - peopleCount[i]);
+        delta = grows ? delta : 0;
+        fraction[i] = grows ? next - delta * PEOPLE_FRACTION_ONE : fraction[i];
+        peopleCount[i] += delta;
+        added[i] += delta;
+    }
+
+    int64_t woodSum = 0, ironSum = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        int rate = K_WOOD_GET * peopleCount[i] * taxes[i] / 100 * efficiency[i] / 100;
+        int delta = std::min(wood[i], rate);
+        wood[i] -= delta;
+        woodSum += delta;
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        int rate = K_IRON_GET * peopleCount[i] * taxes[i] / 100 * efficiency[i] / 100;
+        int delta = std::min(iron[i], rate);
+        iron[i] -= delta;
+        ironSum += delta;
+    }
+    woodGained += woodSum;
+    ironGained += ironSum;
+
+    // Drift towards 100 efficiency for low taxes and towards 0 for high ones
+    for (size_t i = begin; i < end; i++)
+    {
+        int difference = DEFAULT_TAXES - taxes[i];
+        if (abs(difference) <= K_EFFICIENCY) continue;
+        int drift = GetRandomIntAt(RngStream::Economy, index[i], tick, abs(difference));
+        drift /= K_EFFICIENCY;
+        efficiency[i] = std::clamp(efficiency[i] + (difference > 0 ? drift : -drift), 0, 100);
+    }
+}
+
+bool EconomyBatch::IsSteady(size_t i) const
+{
+    // The drift is a number below the difference divided by K_EFFICIENCY
+    int difference = DEFAULT_TAXES - taxes[i];
+    if (difference > 0) return efficiency[i] >= 100 || difference <= K_EFFICIENCY;
+    if (difference < 0) return efficiency[i] <= 0 || -difference <= K_EFFICIENCY;
+    return true;
+}
+
+int64_t EconomyBatch::GetSteadyTicks(size_t i, int64_t limit) const
+{
+    // Islands below 2 people don't grow and full ones only add to the fraction
+    if (peopleCount[i] < 2 || peopleCount[i] == peopleMax[i]) return limit;
+    if (peopleCount[i] > peopleMax[i]) return 0;
+    int64_t growth = GetPeopleGrowth(peopleGrowth[i], peopleCount[i], efficiency[i]);
+    if (growth <= 0) return limit;
+    if (fraction[i] >= PEOPLE_FRACTION_ONE) return 0;
+    int64_t untilGrowth = (PEOPLE_FRACTION_ONE - fraction[i] + growth - 1) / growth;
+    return std::min(untilGrowth - 1, limit);
+}
+
+// Wood regrows up to its limit and then the people take what they can. Both are linear until
+// one of the limits is hit, so whole linear segments are skipped at once
+int64_t AdvanceWood(int& wood, int64_t ticks, int64_t growth, int64_t max, int64_t rate)
+{
+    int64_t count = wood, extracted = 0;
+    while (ticks > 0)
+    {
+        int64_t grown = std::min(count + growth, max);
+        int64_t taken = std::min(grown, rate);
+        if (grown - taken == count)
+        {
+            extracted += taken * ticks;
+            break;
+        }
+        if (growth != rate && count + growth <= max && count + growth >= rate)
+        {
+            int64_t steps = growth > rate ? (max - growth - count) / (growth - rate) + 1
+                                          : (count + growth - rate) / (rate - growth) + 1;
+            steps = std::min(steps, ticks);
+            count += steps * (growth - rate);
+            extracted += steps * rate;
+            ticks -= steps;
+            continue;
+        }
+        count = grown - taken;
+        extracted += taken;
+        ticks--;
+    }
+    wood = count;
+    return extracted;
+}
+
+void EconomyBatch::SteadyTicks(size_t i, int64_t ticks)
+{
+    if (peopleCount[i] >= 2)
+        fraction[i] += GetPeopleGrowth(peopleGrowth[i], peopleCount[i], efficiency[i]) * ticks;
+
+    woodGained += AdvanceWood(wood[i], ticks, woodGrowth[i], woodMax[i],
+                              K_WOOD_GET * peopleCount[i] * taxes[i] / 100 * efficiency[i] / 100);
+
+    int64_t ironRate = K_IRON_GET * peopleCount[i] * taxes[i] / 100 * efficiency[i] / 100;
+    int delta = std::min<int64_t>(iron[i], ironRate * ticks);
+    iron[i] -= delta;
+    ironGained += delta;
+}
+
+// Brings the islands up to economyTick. Islands that were caught up on their own start later, so
+// they are sorted by their next tick and every tick runs for the ones that have started
+void RunEconomyTicks(const std::vector<int>& islandIdxs)
+{
+    PROFILE_SCOPE("Growth ticks");
+    auto& colonized = colonizedIslands;
+    colonized.clear();
+    for (int idx: islandIdxs)
+    {
+        if (islands[idx].colonized && islandTicks[idx] < economyTick)
+            colonized.push_back(idx);
+        else
+            islandTicks[idx] = economyTick;
+    }
+    if (colonized.empty()) return;
+    // Ties by index instead of stable_sort, which allocates a buffer
+    std::sort(colonized.begin(), colonized.end(),
+              [](int a, int b)
+              {
+                  if (islandTicks[a] != islandTicks[b]) return islandTicks[a] < islandTicks[b];
+                  return a < b;
+              });
+
+    auto& batch = economyBatch;
+    batch.Clear();
+    batch.Gather(colonized);
+    size_t started = 0;
+    for (int64_t tick = islandTicks[colonized[0]]; tick < economyTick; tick++)
+    {
+        while (started < colonized.size() && islandTicks[colonized[started]] <= tick)
+            started++;
+        batch.Tick(tick, 0, started);
+        AddMetric(Metric::GrowthTicks, started);
+    }
+    batch.Scatter(economyTick);
+    for (int idx: colonized)
+    {
+        islandTicks[idx] = economyTick;
+    }
+}
+
+void ResetEconomy(int64_t tick)
+{
+    economyTick = tick;
+    islandTicks.assign(islands.size(), tick);
+    economyCursor = 0;
+}
+
+void SetEconomyTick(int64_t tick)
+{
+    if (tick == economyTick) return;
+    economyTick = tick;
+    economyCursor = 0;
+}
+
+void CatchUpEconomy(int islandIdx)
+{
+    if (islandTicks[islandIdx] >= economyTick) return;
+    dueIslands.assign(1, islandIdx);
+    RunEconomyTicks(dueIslands);
+}
+
+bool IsCaughtUp(int islandIdx) { return islandTicks[islandIdx] >= economyTick; }
+
+bool IsEconomyCaughtUp() { return economyCursor >= islands.size(); }
+
+void CatchUpEconomy()
+{
+    dueIslands.clear();
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        if (islandTicks[i] < economyTick) dueIslands.push_back(i);
+    }
+    RunEconomyTicks(dueIslands);
+}
+
+void UpdateEconomy(double phase, double budget)
+{
+    size_t end = std::min(islands.size(), (size_t)ceil(std::max(phase, 0.0) * islands.size()));
+    double start = GetTime();
+    while (economyCursor < end)
+    {
+        dueIslands.clear();
+        for (; economyCursor < end && dueIslands.size() < ECONOMY_SLICE; economyCursor++)
+        {
+            if (islandTicks[economyCursor] < economyTick) dueIslands.push_back(economyCursor);
+        }
+        RunEconomyTicks(dueIslands);
+        if (GetTime() - start >= budget) break;
+    }
+}
+
+void CatchUpOffline(uint64_t firstTick, int64_t ticks)
+{
+    PROFILE_SCOPE("Catch up offline");
+    auto& colonized = colonizedIslands;
+    colonized.clear();
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        if (islands[i].colonized) colonized.push_back(i);
+    }
+
+    auto& batch = economyBatch;
+    batch.Clear();
+    batch.Gather(colonized);
+    for (size_t i = 0; i < colonized.size(); i++)
+    {
+        int64_t tick = 0;
+        while (tick < ticks)
+        {
+            // Efficiency changes randomly until it settles, these ticks are run one by one
+            int64_t steady = batch.IsSteady(i) ? batch.GetSteadyTicks(i, ticks - tick) : 0;
+            if (steady > 0)
+            {
+                batch.SteadyTicks(i, steady);
+                tick += steady;
+            }
+            if (tick < ticks)
+            {
+                batch.Tick(OFFLINE_TICK_FLAG | (firstTick + tick), i, i + 1);
+                tick++;
+            }
+        }
+    }
+    batch.Scatter(OFFLINE_TICK_FLAG | (firstTick + ticks));
+}
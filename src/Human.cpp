@@ -4,34 +4,151 @@
 
 #include "Human.hpp"
 #include "Island.hpp"
-#include "Perlin.hpp"
+#include "Jobs.hpp"
+#include "LandMask.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <raymath.h>
 
 #define MIN_ANGLE -15
 #define MAX_ANGLE 15
 
+// Directions a human can pick when turning away from the coast
+#define HEADING_COUNT 256
+// Amount of new directions tried before a human gives up for this frame
+#define TURN_ATTEMPTS 4
+// Humans moved by one job
+#define PEOPLE_CHUNK 4096
+
 std::vector<Human> people;
+std::vector<std::vector<uint32_t>> islandPeople;
+
+void AddHuman(Vector2 pos, int islandIdx)
+{
+    if ((size_t)islandIdx >= islandPeople.size()) islandPeople.resize(islandIdx + 1);
+    people.emplace_back(pos, islandIdx);
+    people.back().islandSlot = islandPeople[islandIdx].size();
+    islandPeople[islandIdx].push_back(people.size() - 1);
+}
+
+void RemoveHuman(uint32_t idx)
+{
+    // Take it out of its island's list
+    Human& human = people[idx];
+    auto& list = islandPeople[human.islandIdx];
+    list[human.islandSlot] = list.back();
+    people[list.back()].islandSlot = human.islandSlot;
+    list.pop_back();
+
+    // Move the last human into its place
+    uint32_t last = people.size() - 1;
+    if (idx != last)
+    {
+        people[idx] = people[last];
+        islandPeople[people[idx].islandIdx][people[idx].islandSlot] = idx;
+    }
+    people.pop_back();
+}
+
+void RemoveIslandPeople(int islandIdx, int count)
+{
+    if (islandIdx < 0 || (size_t)islandIdx >= islandPeople.size()) return;
+    auto& list = islandPeople[islandIdx];
+    for (int i = 0; i < count && !list.empty(); i++)
+    {
+        RemoveHuman(list.back());
+    }
+}
+
+void RebuildPeopleIndex()
+{
+    islandPeople.assign(islands.size(), {});
+    for (size_t i = 0; i < people.size(); i++)
+    {
+        int islandIdx = people[i].islandIdx;
+        if (islandIdx < 0) continue;
+        if ((size_t)islandIdx >= islandPeople.size()) islandPeople.resize(islandIdx + 1);
+        people[i].islandSlot = islandPeople[islandIdx].size();
+        islandPeople[islandIdx].push_back(i);
+    }
+}
+
+struct HeadingTable
+{
+    Vector2 dirs[HEADING_COUNT];
+    HeadingTable()
+    {
+        for (int i = 0; i < HEADING_COUNT; i++)
+        {
+            float angle = 2 * PI * i / HEADING_COUNT;
+            dirs[i] = {cosf(angle), sinf(angle)};
+        }
+    }
+};
+const HeadingTable headings;
+
+void Human::SetHeading(int heading)
+{
+    rotation = 2 * PI * heading / HEADING_COUNT;
+    dir = headings.dirs[heading];
+}
 
-void Human::MoveToTarget(double deltaTime)
+void MoveChunk(size_t begin, size_t end, float deltaTime, Rng& rng)
 {
-    Vector2 delta = Vector2Rotate({speed, 0}, rotation) * deltaTime;
-    bool found = false;
-    for (size_t i = 0; i < 5; i++)
+    thread_local std::vector<uint32_t> blocked;
+    blocked.clear();
+
+    // Walk along the current heading and animate the swinging in a single pass
+    for (size_t i = begin; i < end; i++)
     {
-        if (GetPerlin(pos + delta) >= LAND_START && InsideMap(pos + delta))
+        Human& human = people[i];
+        Vector2 next = human.pos + human.dir * (human.speed * deltaTime);
+        if (IsWalkable(next))
+            human.pos = next;
+        else
+            blocked.push_back(i);
+
+        human.angle += human.angleMultiplier * human.rotationSpeed * deltaTime;
+        if (human.angle < MIN_ANGLE) human.angleMultiplier = 1;
+        if (human.angle > MAX_ANGLE) human.angleMultiplier = -1;
+        human.angle = fmaxf(MIN_ANGLE, fminf(MAX_ANGLE, human.angle));
+    }
+
+    // Humans that reached the coast turn to a random direction
+    for (uint32_t i: blocked)
+    {
+        Human& human = people[i];
+        for (int attempt = 0; attempt < TURN_ATTEMPTS; attempt++)
         {
-            found = true;
+            human.SetHeading(rng.Next() % HEADING_COUNT);
+            Vector2 next = human.pos + human.dir * (human.speed * deltaTime);
+            if (!IsWalkable(next)) continue;
+            human.pos = next;
             break;
         }
-        rotation = GetRandomFloat(0, 360);
-        delta = Vector2Rotate({speed, 0}, rotation) * deltaTime;
     }
-    if (found) pos += delta;
+}
 
-    angle += angleMultiplier * rotationSpeed * deltaTime;
-    if (angle < MIN_ANGLE) angleMultiplier = 1;
-    if (angle > MAX_ANGLE) angleMultiplier = -1;
-    angle = fmax(MIN_ANGLE, fmin(MAX_ANGLE, angle));
+void MovePeople(float deltaTime)
+{
+    PROFILE_SCOPE("Move people");
+    // Each chunk draws from its own generator, so the result doesn't depend on the thread count
+    uint64_t step = ++movementStep;
+    size_t chunks = (people.size() + PEOPLE_CHUNK - 1) / PEOPLE_CHUNK;
+    ParallelFor(0, chunks, 1,
+                [deltaTime, step](size_t begin, size_t end)
+                {
+                    for (size_t chunk = begin; chunk < end; chunk++)
+                    {
+                        Rng rng = MakeRng(RngStream::Movement, step << 32 | chunk);
+                        MoveChunk(chunk * PEOPLE_CHUNK,
+                                  std::min(people.size(), (chunk + 1) * PEOPLE_CHUNK), deltaTime,
+                                  rng);
+                    }
+                });
 }
 
 Json Human::ToJSON()
@@ -59,6 +176,7 @@ Human Human::LoadJSON(Json& json)
                  static_cast<float>(json["pos"][1].GetDouble())};
     human.angle = json["angle"].GetDouble();
     human.rotation = json["rotation"].GetDouble();
+    human.dir = {cosf(human.rotation), sinf(human.rotation)};
     human.islandIdx = json["islandIdx"].GetInt();
     human.speed = json["speed"].GetDouble();
     human.rotationSpeed = json["rotationSpeed"].GetDouble();
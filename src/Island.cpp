@@ -5,22 +5,31 @@
 
 #include "Island.hpp"
 #include "Drawing.hpp"
+#include "Economy.hpp"
 #include "Human.hpp"
+#include "IslandOutline.hpp"
+#include "IslandRaster.hpp"
+#include "Jobs.hpp"
+#include "LandMask.hpp"
 #include "Languages.hpp"
+#include "Metrics.hpp"
 #include "Pathfinding.hpp"
 #include "Perlin.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
 #include "Settings.hpp"
 #include "Ship.hpp"
+#include "Simulation.hpp"
 #include "UI.hpp"
 #include "Utils.hpp"
 #include <algorithm>
-#include <cfloat>
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <raygui.h>
 #include <raymath.h>
-#include <unordered_map>
 
 #define K_WOOD_COLONIZE 0.05f
 #define K_IRON_COLONIZE 0.004f
@@ -31,10 +40,6 @@
 #define K_PEOPLE_GROWTH 0.001f
 #define K_PEOPLE_MAX 0.1f
 
-#define K_WOOD_GET 3
-#define K_IRON_GET 1
-#define K_EFFICIENCY 5
-
 inline Color rgb(unsigned char r, unsigned char g, unsigned char b) { return {r, g, b, 255}; }
 
 std::vector<Biome> biomes = {{-1, rgb(0, 0, 255)},     {-0.5, rgb(0, 136, 255)},
@@ -42,106 +47,163 @@ std::vector<Biome> biomes = {{-1, rgb(0, 0, 255)},     {-0.5, rgb(0, 136, 255)},
                              {0.2, rgb(33, 171, 42)},  {0.5, rgb(184, 184, 205)},
                              {0.6, rgb(255, 255, 255)}};
 std::vector<Island> islands;
+PopulationHeap populationHeap;
 
 int woodTotal = 0, ironTotal = 0, peopleTotal = 0;
 
-Vector2 Island::GetRandomPoint()
+bool PopulationHeap::Before(int a, int b) const
 {
-    Vector2 pos;
-    do
-    {
-        pos.x = GetRandomFloat(p1.x, p2.x);
-        pos.y = GetRandomFloat(p1.y, p2.y);
-    } while (GetPerlin(pos) < LAND_START);
-    return pos;
+    if (islands[a].peopleCount != islands[b].peopleCount)
+        return islands[a].peopleCount > islands[b].peopleCount;
+    return a < b;
 }
 
-void Island::Colonize()
+void PopulationHeap::Swap(size_t i, size_t j)
 {
-    if (colonized || colonizationInProgress || woodTotal < woodColonize || ironTotal < ironColonize)
-        return;
-    colonizationInProgress = true;
-    woodTotal -= woodColonize;
-    ironTotal -= ironColonize;
-    SendPeople(1);
+    std::swap(heap[i], heap[j]);
+    position[heap[i]] = i;
+    position[heap[j]] = j;
 }
 
-void Island::SendPeople(int count)
+void PopulationHeap::SiftUp(size_t i)
 {
-    if (futurePeopleCount + count > peopleMax) return;
-    int maxPeopleIslandId = (&islands[0] == this ? 1 : 0);
-    for (size_t i = 0; i < islands.size(); i++)
+    while (i > 0 && Before(heap[i], heap[(i - 1) / 2]))
     {
-        if (&islands[i] == this) continue;
-        if (islands[i].peopleCount > islands[maxPeopleIslandId].peopleCount) maxPeopleIslandId = i;
+        Swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
     }
-    if (islands[maxPeopleIslandId].peopleCount < count) return;
-    islands[maxPeopleIslandId].peopleCount -= count;
-    futurePeopleCount += count;
-    ships.emplace_back(islands[maxPeopleIslandId].index, this->index, count);
+}
 
-    int counter = 0;
-    for (auto it = people.begin(); it != people.end();)
+void PopulationHeap::SiftDown(size_t i)
+{
+    while (true)
     {
-        if (counter >= count) break;
-        if (it->islandIdx != maxPeopleIslandId)
-        {
-            ++it;
-            continue;
-        }
-        it = people.erase(it);
-        counter++;
+        size_t best = i, left = i * 2 + 1, right = i * 2 + 2;
+        if (left < heap.size() && Before(heap[left], heap[best])) best = left;
+        if (right < heap.size() && Before(heap[right], heap[best])) best = right;
+        if (best == i) return;
+        Swap(i, best);
+        i = best;
     }
 }
 
-void Island::AddPeople(int count)
+void PopulationHeap::Build()
 {
-    if (!colonized) colonized = true;
-    peopleCount += count;
-    for (int i = 0; i < count; i++)
+    heap.resize(islands.size());
+    position.resize(islands.size());
+    for (size_t i = 0; i < islands.size(); i++)
     {
-        people.emplace_back(GetRandomPoint(), index);
+        heap[i] = position[i] = i;
+    }
+    for (size_t i = heap.size() / 2; i-- > 0;)
+    {
+        SiftDown(i);
     }
 }
 
-void Island::GrowthTick()
+void PopulationHeap::Update(int islandIdx)
 {
-    if (!colonized) return;
-    woodCount += woodGrowth;
-    woodCount = fmin(woodCount, woodMax);
-    if (peopleCount >= 2)
+    if (position.size() != islands.size())
     {
-        addPeopleFraction += peopleGrowth * sqrt(peopleCount) * efficiency / 100;
-
-        int delta = addPeopleFraction;
-        delta = fmin(delta, peopleMax - peopleCount);
-        addPeopleFraction -= delta;
-        peopleCount += delta;
-        peopleTotal += delta;
-        for (int i = 0; i < delta; i++)
-        {
-            people.emplace_back(GetRandomPoint(), index);
-        }
+        Build();
+        return;
     }
+    SiftUp(position[islandIdx]);
+    SiftDown(position[islandIdx]);
+}
+
+int PopulationHeap::TopExcept(int islandIdx) const
+{
+    if (heap.empty()) return -1;
+    if (heap[0] != islandIdx) return heap[0];
+    // The runner-up is one of the root's children
+    int best = -1;
+    for (size_t i = 1; i <= 2 && i < heap.size(); i++)
     {
-        int delta = fmin(woodCount, K_WOOD_GET * peopleCount * taxes / 100 * efficiency / 100);
-        woodCount -= delta;
-        woodTotal += delta;
+        if (best == -1 || Before(heap[i], best)) best = heap[i];
     }
+    return best;
+}
+
+Vector2 Island::GetRandomPoint()
+{
+    Vector2 pos;
+    if (GetRandomIslandPoint(index, pos)) return pos;
+
+    // Islands of another map, e.g. while migrating the saves
+    do
     {
-        int delta = fmin(ironCount, K_IRON_GET * peopleCount * taxes / 100 * efficiency / 100);
-        ironCount -= delta;
-        ironTotal += delta;
-    }
-    if (taxes < DEFAULT_TAXES)
+        pos.x = GetRandomFloat(p1.x, p2.x);
+        pos.y = GetRandomFloat(p1.y, p2.y);
+        AddMetric(Metric::NoiseEvaluations);
+    } while (GetPerlin(pos) < LAND_START);
+    return pos;
+}
+
+// Only the islands that come out on top run their due ticks, the others are compared by the
+// population of their last tick. A tick never lowers the population, so the loop ends with an
+// island that is up to date
+int Island::FindSource()
+{
+    int sourceIdx = populationHeap.TopExcept(index);
+    while (sourceIdx >= 0 && !IsCaughtUp(sourceIdx))
     {
-        efficiency += rand() % (DEFAULT_TAXES - taxes) / K_EFFICIENCY;
-        efficiency = fmin(100, efficiency);
+        CatchUpEconomy(sourceIdx);
+        sourceIdx = populationHeap.TopExcept(index);
     }
-    if (taxes > DEFAULT_TAXES)
+    return sourceIdx;
+}
+
+void Island::TakePeople(int sourceIdx, int count)
+{
+    if (islands[sourceIdx].peopleCount < count) return;
+    islands[sourceIdx].peopleCount -= count;
+    populationHeap.Update(sourceIdx);
+    futurePeopleCount += count;
+    RequestShip(sourceIdx, index, count);
+    RemoveIslandPeople(sourceIdx, count);
+}
+
+void Island::Colonize(int sourceIdx)
+{
+    CatchUpEconomy(index);
+    if (colonized || colonizationInProgress) return;
+    // The totals miss the income of the islands that are behind, only a refused click pays for
+    // running their ticks
+    if (woodTotal < woodColonize || ironTotal < ironColonize) CatchUpEconomy();
+    if (woodTotal < woodColonize || ironTotal < ironColonize) return;
+    sourceIdx = sourceIdx < 0 ? FindSource() : sourceIdx;
+    // Don't take the resources if no ship can get here
+    if (sourceIdx < 0 || !IsReachable(sourceIdx, index)) return;
+    CatchUpEconomy(sourceIdx);
+    // The source depends on which islands were up to date, so the replay is given the same one
+    RecordAction(ReplayActionType::Colonize, index, sourceIdx);
+    colonizationInProgress = true;
+    woodTotal -= woodColonize;
+    ironTotal -= ironColonize;
+    TakePeople(sourceIdx, 1);
+}
+
+void Island::SendPeople(int count, int sourceIdx)
+{
+    CatchUpEconomy(index);
+    if (futurePeopleCount + count > peopleMax) return;
+    sourceIdx = sourceIdx < 0 ? FindSource() : sourceIdx;
+    if (sourceIdx < 0 || !IsReachable(sourceIdx, index)) return;
+    CatchUpEconomy(sourceIdx);
+    RecordAction(ReplayActionType::SendPeople, index, sourceIdx);
+    TakePeople(sourceIdx, count);
+}
+
+void Island::AddPeople(int count)
+{
+    CatchUpEconomy(index);
+    if (!colonized) colonized = true;
+    peopleCount += count;
+    populationHeap.Update(index);
+    for (int i = 0; i < count; i++)
     {
-        efficiency -= rand() % (taxes - DEFAULT_TAXES) / K_EFFICIENCY;
-        efficiency = fmax(0, efficiency);
+        AddHuman(GetRandomPoint(), index);
     }
 }
 
@@ -156,8 +218,8 @@ void Island::DrawStats()
                 ironScale = 0.15f * scale, humanScale = 0.075f * scale, textScale = 175 * scale,
                 buttonScale = 300 * scale;
 
-    // Calculate the center point of the island
-    Vector2 center = GlslToRaylib((p2 + p1) / 2);
+    // Place the stats at the centroid of the island
+    Vector2 center = GlslToRaylib(this->center);
     center.x -= lockTexture.width * scale / 2;
     center.y -= lockTexture.height * scale / 2;
 
@@ -194,7 +256,7 @@ void Island::DrawStats()
                   woodScale, WHITE);
     {
         Vector2 textOffset = GetTextOffset(woodTexture, woodScale);
-        DrawTextCustom(std::to_string(colonized ? woodCount : woodColonize).c_str(), textOffset,
+        DrawTextCustom(TextFormat("%d", colonized ? woodCount : woodColonize), textOffset,
                        textScale, WHITE);
     }
     offset.y += woodTexture.height * woodScale + margin;
@@ -204,7 +266,7 @@ void Island::DrawStats()
                   ironScale, WHITE);
     {
         Vector2 textOffset = GetTextOffset(ironTexture, ironScale);
-        DrawTextCustom(std::to_string(colonized ? ironCount : ironColonize).c_str(), textOffset,
+        DrawTextCustom(TextFormat("%d", colonized ? ironCount : ironColonize), textOffset,
                        textScale, WHITE);
     }
     offset.y += ironTexture.height * ironScale + margin;
@@ -217,7 +279,7 @@ void Island::DrawStats()
                       humanScale, WHITE);
         {
             Vector2 textOffset = GetTextOffset(humanTexture, humanScale);
-            DrawTextCustom(std::to_string(peopleCount).c_str(), textOffset, textScale, WHITE);
+            DrawTextCustom(TextFormat("%d", peopleCount), textOffset, textScale, WHITE);
         }
         offset.y += humanTexture.height * humanScale + margin;
     }
@@ -254,7 +316,7 @@ Json Island::ToJSON()
     json["peopleCount"] = peopleCount;
     json["peopleMax"] = peopleMax;
     json["peopleGrowth"] = peopleGrowth;
-    json["addPeopleFraction"] = addPeopleFraction;
+    json["addPeopleFraction"] = (double)addPeopleFraction / PEOPLE_FRACTION_ONE;
     json["colonized"] = colonized;
     json["taxes"] = taxes;
     json["efficiency"] = efficiency;
@@ -279,88 +341,201 @@ Island Island::LoadJSON(Json& json)
     island.peopleCount = json["peopleCount"].GetInt();
     island.peopleMax = json["peopleMax"].GetInt();
     island.peopleGrowth = json["peopleGrowth"].GetDouble();
-    island.addPeopleFraction = json["addPeopleFraction"].GetDouble();
+    island.addPeopleFraction = json["addPeopleFraction"].GetDouble() * PEOPLE_FRACTION_ONE;
     island.colonized = json["colonized"].GetBool();
     island.taxes = json["taxes"].GetInt();
     island.efficiency = json["efficiency"].GetInt();
     return island;
 }
 
-void BuildIslands(float& loadingPercent, std::atomic<bool>& finished, float stepSize)
+#define NO_LABEL UINT32_MAX
+
+struct LabelStats
+{
+    int area = 0;
+    int minX = INT_MAX, minY = INT_MAX, maxX = -1, maxY = -1;
+};
+
+// Union-find over the labels of the land found while scanning the rows. Joined labels add their
+// stats to the root, the smaller label stays the root so the islands keep the scan order
+struct LandLabels
 {
-    // Find islands
+    std::vector<uint32_t> parent;
+    std::vector<LabelStats> stats;
+
+    uint32_t Add()
+    {
+        parent.push_back(parent.size());
+        stats.emplace_back();
+        return parent.back();
+    }
+
+    uint32_t Find(uint32_t label)
+    {
+        while (parent[label] != label)
+        {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+
+    uint32_t Join(uint32_t a, uint32_t b)
+    {
+        a = Find(a), b = Find(b);
+        if (a == b) return a;
+        if (a > b) std::swap(a, b);
+        parent[b] = a;
+        auto &to = stats[a], &from = stats[b];
+        to.area += from.area;
+        to.minX = std::min(to.minX, from.minX);
+        to.minY = std::min(to.minY, from.minY);
+        to.maxX = std::max(to.maxX, from.maxX);
+        to.maxY = std::max(to.maxY, from.maxY);
+        return a;
+    }
+
+    void AddCell(uint32_t root, int x, int y)
+    {
+        auto& cell = stats[root];
+        cell.area++;
+        cell.minX = std::min(cell.minX, x);
+        cell.minY = std::min(cell.minY, y);
+        cell.maxX = std::max(cell.maxX, x);
+        cell.maxY = std::max(cell.maxY, y);
+    }
+
+    // Points every label straight at its root. Parents are never larger than their children, so
+    // one pass in order is enough
+    void Flatten()
+    {
+        for (size_t i = 0; i < parent.size(); i++)
+        {
+            parent[i] = parent[parent[i]];
+        }
+    }
+};
+
+void BuildIslands(std::atomic<float>& loadingPercent, float stepSize)
+{
+    PROFILE_SCOPE("Build islands");
+    // Find islands. The noise is sampled in parallel, one block of rows at a time, and only the
+    // labels of the last two rows are kept
     size_t maxX = ceil(mapSize.x / stepSize) + 1, maxY = ceil(mapSize.y / stepSize) + 1;
-    std::vector<std::vector<int>> map(maxY, std::vector<int>(maxX, INT_MAX));
-    std::unordered_map<int, int> same;
-    size_t counter = 0;
+    LandLabels landLabels;
+    std::vector<uint32_t> previousRow(maxX, NO_LABEL), row(maxX, NO_LABEL);
+    const size_t blockRows = 64;
+    std::vector<uint8_t> land(blockRows * maxX);
+
+    // Rows and columns the cells of the island raster take their labels from. The labels are
+    // kept per raster cell until the roots are known
+    ResizeIslandRaster();
+    std::vector<uint32_t> rasterLabels(islandRaster.size(), NO_LABEL);
+    std::vector<size_t> rasterColumns(islandRasterWidth);
+    for (int x = 0; x < islandRasterWidth; x++)
+    {
+        float posX = islandRasterOrigin.x + (x + 0.5f) / ISLAND_RASTER_RES;
+        rasterColumns[x] = std::min<size_t>(roundf((posX + mapSize.x / 2) / stepSize), maxX - 1);
+    }
+    int rasterY = 0;
+    auto GetRasterRow = [&](int y)
+    {
+        float posY = islandRasterOrigin.y + (y + 0.5f) / ISLAND_RASTER_RES;
+        return std::min<size_t>(roundf((posY + mapSize.y / 2) / stepSize), maxY - 1);
+    };
+
     for (size_t i = 0; i < maxY; i++)
     {
+        if (i % blockRows == 0)
+        {
+            size_t blockStart = i;
+            ParallelFor(blockStart, std::min(maxY, blockStart + blockRows), 1,
+                        [&](size_t begin, size_t end)
+                        {
+                            for (size_t y = begin; y < end; y++)
+                            {
+                                for (size_t x = 0; x < maxX; x++)
+                                {
+                                    Vector2 pos = {x * stepSize - mapSize.x / 2,
+                                                   y * stepSize - mapSize.y / 2};
+                                    land[(y - blockStart) * maxX + x] =
+                                        GetPerlin(pos) >= LAND_START;
+                                }
+                            }
+                            AddMetric(Metric::NoiseEvaluations, (end - begin) * maxX);
+                        });
+        }
+
+        std::swap(previousRow, row);
         for (size_t j = 0; j < maxX; j++)
         {
-            if (GetPerlin({j * stepSize - mapSize.x / 2, i * stepSize - mapSize.y / 2}) <
-                LAND_START)
-                continue;
-            if (j > 0) map[i][j] = fmin(map[i][j], map[i][j - 1]);
-            if (i > 0) map[i][j] = fmin(map[i][j], map[i - 1][j]);
-            if (j > 0 && i > 0)
+            if (!land[(i % blockRows) * maxX + j])
             {
-                auto n1 = map[i][j - 1], n2 = map[i - 1][j];
-                if (n1 > n2) std::swap(n1, n2);
-                if (n1 != n2 && same.find(n2) == same.end()) same[n2] = n1;
+                row[j] = NO_LABEL;
+                continue;
             }
-            if (map[i][j] == INT_MAX) map[i][j] = counter++;
+            uint32_t left = j > 0 ? row[j - 1] : NO_LABEL, up = previousRow[j];
+            if (left != NO_LABEL && up != NO_LABEL)
+                row[j] = landLabels.Join(left, up);
+            else if (left != NO_LABEL || up != NO_LABEL)
+                row[j] = landLabels.Find(left != NO_LABEL ? left : up);
+            else
+                row[j] = landLabels.Add();
+            landLabels.AddCell(row[j], j, i);
         }
-        loadingPercent += 1.0f / maxY / 2 * 100;
-    }
-    std::cout << "Total island count: " << counter - same.size() << '\n';
 
-    // Calculate islands' areas
-    std::vector<int> islandAreas(counter, 0);
-    std::vector<std::pair<Vector2, Vector2>> islandCorners(
-        counter, {{FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX}});
-    for (size_t i = 0; i < maxY; i++)
-    {
-        for (size_t j = 0; j < maxX; j++)
+        for (; rasterY < islandRasterHeight && GetRasterRow(rasterY) == i; rasterY++)
         {
-            if (map[i][j] == INT_MAX) continue;
-
-            int idx = map[i][j];
-            while (same.find(idx) != same.end())
-                idx = same[idx];
-            map[i][j] = idx;
-            islandAreas[idx]++;
-
-            auto& corner = islandCorners[idx];
-            corner.first.x = fmin(corner.first.x, j * stepSize - mapSize.x / 2);
-            corner.first.y = fmin(corner.first.y, i * stepSize - mapSize.y / 2);
-            corner.second.x = fmax(corner.second.x, j * stepSize - mapSize.x / 2);
-            corner.second.y = fmax(corner.second.y, i * stepSize - mapSize.y / 2);
+            for (int x = 0; x < islandRasterWidth; x++)
+            {
+                rasterLabels[(size_t)rasterY * islandRasterWidth + x] = row[rasterColumns[x]];
+            }
         }
-        loadingPercent += 1.0f / maxY / 2 * 100;
+        loadingPercent = loadingPercent + 1.0f / maxY * 100;
     }
+    landLabels.Flatten();
 
     // Add large enough islands to the main vector
     int minIslandArea = 125 / stepSize / stepSize;
-    int passed = 0;
+    int passed = 0, total = 0;
     islands.clear();
-    for (size_t i = 0; i < counter; i++)
+    std::vector<uint16_t> islandOf(landLabels.parent.size(), 0);
+    for (size_t i = 0; i < landLabels.parent.size(); i++)
     {
-        if (islandAreas[i] < minIslandArea) continue;
-
-        auto& corner = islandCorners[i];
-        Vector2 center = {(corner.second.x + corner.first.x) / 2,
-                          (corner.second.y + corner.first.y) / 2};
+        if (landLabels.parent[i] != i) continue;
+        total++;
+        auto& stats = landLabels.stats[i];
+        if (stats.area < minIslandArea) continue;
+
+        Vector2 p1 = {(size_t)stats.minX * stepSize - mapSize.x / 2,
+                      (size_t)stats.minY * stepSize - mapSize.y / 2};
+        Vector2 p2 = {(size_t)stats.maxX * stepSize - mapSize.x / 2,
+                      (size_t)stats.maxY * stepSize - mapSize.y / 2};
+        Vector2 center = {(p2.x + p1.x) / 2, (p2.y + p1.y) / 2};
         float distance = Vector2Distance(center, {0, 0});
-        float area = islandAreas[i] * stepSize * stepSize;
+        float area = stats.area * stepSize * stepSize;
         float cost = distance * area;
-        islands.emplace_back(corner.first, corner.second, area, cost * K_WOOD_COLONIZE,
-                             cost * K_IRON_COLONIZE, cost * K_WOOD, cost * K_WOOD_GROWTH,
-                             cost * K_IRON, area * K_PEOPLE_GROWTH, area * K_PEOPLE_MAX);
+        islands.emplace_back(p1, p2, area, cost * K_WOOD_COLONIZE, cost * K_IRON_COLONIZE,
+                             cost * K_WOOD, cost * K_WOOD_GROWTH, cost * K_IRON,
+                             area * K_PEOPLE_GROWTH, area * K_PEOPLE_MAX);
         islands.back().index = islands.size() - 1;
+        islandOf[i] = islands.size();
         passed++;
     }
+    std::cout << "Total island count: " << total << '\n';
     std::cout << "Found " << passed << " large enough islands\n";
 
+    // Keep the labels at a lower resolution for IslandAt
+    ParallelFor(0, rasterLabels.size(), 4096,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        if (rasterLabels[i] == NO_LABEL) continue;
+                        islandRaster[i] = islandOf[landLabels.parent[rasterLabels[i]]];
+                    }
+                });
+
     // Set the closest island to center as colonized
     int minDistanceIslandIdx = 0;
     for (size_t i = 0; i < islands.size(); i++)
@@ -372,30 +547,54 @@ void BuildIslands(float& loadingPercent, std::atomic<bool>& finished, float step
     }
     islands[minDistanceIslandIdx].colonized = true;
 
+    BuildLandMask();
+    BuildIslandCells();
+    BuildIslandOutlines();
+
     // Set start resources
+    people.clear();
+    RebuildPeopleIndex();
     auto& startIsland = islands[minDistanceIslandIdx];
     peopleTotal = startIsland.area * K_PEOPLE;
     peopleTotal = fmax(2, peopleTotal);
     startIsland.peopleCount = peopleTotal;
     for (int i = 0; i < startIsland.peopleCount; i++)
     {
-        people.emplace_back(startIsland.GetRandomPoint(), minDistanceIslandIdx);
+        AddHuman(startIsland.GetRandomPoint(), minDistanceIslandIdx);
     }
 
     // Prevent softlocking by having enough people to extract iron and enough iron to colonize
     startIsland.peopleMax = fmax(3, startIsland.peopleMax);
     startIsland.ironCount *= 10;
 
-    finished = true;
+    populationHeap.Build();
 }
 
-void BuildMap()
+void BuildMap(bool headless)
 {
-    auto func = [](std::string& label, float& loadingPercent, std::atomic<bool>& finished)
+    CancelPathMap();
+    SeedRandom(perlinSeed);
+    auto func = [](LoadingState& loading)
     {
-        label = labels["Loading map..."];
+        // A headless build runs on the calling thread, so its generator is put back
+        Rng* lastRng = SetThreadRng(&GetRng(RngStream::World));
+        loading.SetLabel(labels["Loading map..."]);
         woodTotal = ironTotal = peopleTotal = 0;
-        BuildIslands(loadingPercent, finished, 0.1f);
+        simulationTime = 0;
+        BuildIslands(loading.percent, 0.1f);
+        SetThreadRng(lastRng);
     };
-    ShowLoadingScreen(true, func);
+    if (headless)
+    {
+        LoadingState loading;
+        func(loading);
+    }
+    else
+        ShowLoadingScreen(true, func);
+    // Routes of the old map are gone, so its ships are too
+    ships.Clear();
+    shipRequests.clear();
+    ResetSimulationEvents();
+    GeneratePathMap();
+    StartRecording();
 }
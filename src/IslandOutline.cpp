@@ -0,0 +1,301 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "IslandOutline.hpp"
+#include "Island.hpp"
+#include "IslandRaster.hpp"
+#include "Jobs.hpp"
+#include "MemoryStats.hpp"
+#include "Metrics.hpp"
+#include "Perlin.hpp"
+#include "Settings.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <raymath.h>
+
+// Outlines of the last map they were built for
+struct OutlineCache
+{
+    int seed = -1;
+    Vector2 mapSize = {0, 0};
+    float tolerance = 0;
+    std::vector<std::vector<Vector2>> outlines;
+};
+
+OutlineCache outlineCache;
+
+// Noise at the centers of the raster cells minus LAND_START, only kept for the last seed
+std::vector<float> outlineField;
+int outlineFieldSeed = -1;
+Vector2 outlineFieldMapSize = {0, 0};
+
+void BuildOutlineField()
+{
+    if (outlineFieldSeed == perlinSeed && outlineFieldMapSize.x == mapSize.x &&
+        outlineFieldMapSize.y == mapSize.y && outlineField.size() == islandRaster.size())
+        return;
+
+    outlineField.resize(islandRaster.size());
+    ParallelFor(0, islandRasterHeight, 16,
+                [](size_t begin, size_t end)
+                {
+                    for (size_t y = begin; y < end; y++)
+                    {
+                        for (int x = 0; x < islandRasterWidth; x++)
+                        {
+                            Vector2 center = {
+                                islandRasterOrigin.x + (x + 0.5f) / ISLAND_RASTER_RES,
+                                islandRasterOrigin.y + (y + 0.5f) / ISLAND_RASTER_RES};
+                            outlineField[y * islandRasterWidth + x] =
+                                GetPerlin(center) - LAND_START;
+                        }
+                    }
+                    AddMetric(Metric::NoiseEvaluations, (end - begin) * islandRasterWidth);
+                });
+    outlineFieldSeed = perlinSeed;
+    outlineFieldMapSize = mapSize;
+}
+
+std::vector<Vector2> TraceIsland(int islandIdx, int minX, int minY, int maxX, int maxY)
+{
+    // Corners of the marching squares are the raster cells plus a ring of water around them
+    minX--, minY--, maxX++, maxY++;
+    const int width = maxX - minX + 1, height = maxY - minY + 1;
+    std::vector<float> values(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int rx = x + minX, ry = y + minY;
+            float value = -1;
+            if (rx >= 0 && ry >= 0 && rx < islandRasterWidth && ry < islandRasterHeight)
+            {
+                int cell = ry * islandRasterWidth + rx;
+                // Other islands count as water
+                if (islandRaster[cell] == islandIdx + 1)
+                    value = fmaxf(outlineField[cell], 1e-4f);
+                else
+                    value = fminf(outlineField[cell], -1e-4f);
+            }
+            values[y * width + x] = value;
+        }
+    }
+
+    // Edge ids: 2 * corner for the edge to the right, 2 * corner + 1 for the edge above
+    auto corner = [width](int x, int y) { return y * width + x; };
+    std::vector<Vector2> points(width * height * 2);
+    std::vector<int> links(width * height * 4, -1);
+    auto link = [&links](int a, int b)
+    {
+        links[a * 2 + (links[a * 2] != -1)] = b;
+        links[b * 2 + (links[b * 2] != -1)] = a;
+    };
+    auto toWorld = [&](float x, float y) -> Vector2
+    {
+        return {islandRasterOrigin.x + (x + minX + 0.5f) / ISLAND_RASTER_RES,
+                islandRasterOrigin.y + (y + minY + 0.5f) / ISLAND_RASTER_RES};
+    };
+
+    for (int y = 0; y + 1 < height; y++)
+    {
+        for (int x = 0; x + 1 < width; x++)
+        {
+            const int corners[4] = {corner(x, y), corner(x + 1, y), corner(x + 1, y + 1),
+                                    corner(x, y + 1)};
+            // Edge k goes from corner k to corner k + 1
+            const int edges[4] = {corners[0] * 2, corners[1] * 2 + 1, corners[3] * 2,
+                                  corners[0] * 2 + 1};
+            bool inside[4];
+            int insideCount = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                inside[k] = values[corners[k]] >= 0;
+                insideCount += inside[k];
+            }
+            if (insideCount == 0 || insideCount == 4) continue;
+
+            bool crossed[4];
+            for (int k = 0; k < 4; k++)
+            {
+                int a = corners[k], b = corners[(k + 1) % 4];
+                crossed[k] = inside[k] != inside[(k + 1) % 4];
+                if (!crossed[k]) continue;
+                float t = values[a] / (values[a] - values[b]);
+                Vector2 pa = {float(a % width), float(a / width)};
+                Vector2 pb = {float(b % width), float(b / width)};
+                Vector2 p = Vector2Lerp(pa, pb, t);
+                points[edges[k]] = toWorld(p.x, p.y);
+            }
+
+            // Diagonal corners: cut off the two corners that disagree with the cell's center
+            if (insideCount == 2 && inside[0] == inside[2])
+            {
+                float center = (values[corners[0]] + values[corners[1]] + values[corners[2]] +
+                                values[corners[3]]) /
+                               4;
+                int first = inside[0] != (center >= 0) ? 0 : 1;
+                link(edges[(first + 3) % 4], edges[first]);
+                link(edges[(first + 1) % 4], edges[(first + 2) % 4]);
+                continue;
+            }
+
+            int ends[2], count = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                if (crossed[k]) ends[count++] = edges[k];
+            }
+            link(ends[0], ends[1]);
+        }
+    }
+
+    // Chain the segments into loops and keep the longest one, the rest are lakes
+    std::vector<Vector2> best, loop;
+    std::vector<uint8_t> visited(points.size(), 0);
+    for (size_t start = 0; start < points.size(); start++)
+    {
+        if (visited[start] || links[start * 2] == -1) continue;
+        loop.clear();
+        int previous = -1, current = start;
+        while (current != -1 && !visited[current])
+        {
+            visited[current] = true;
+            loop.push_back(points[current]);
+            int next = links[current * 2] != previous ? links[current * 2] : links[current * 2 + 1];
+            previous = current;
+            current = next;
+        }
+        if (loop.size() > best.size()) std::swap(best, loop);
+    }
+    return best;
+}
+
+void BuildIslandOutlines()
+{
+    OutlineCache& entry = outlineCache;
+    bool cached = entry.seed == perlinSeed && entry.mapSize.x == mapSize.x &&
+                  entry.mapSize.y == mapSize.y && entry.tolerance == outlineTolerance &&
+                  entry.outlines.size() == islands.size();
+    if (!cached)
+    {
+        BuildOutlineField();
+
+        // Raster bounds of every island
+        std::vector<int> minX(islands.size(), INT_MAX), minY(islands.size(), INT_MAX),
+            maxX(islands.size(), -1), maxY(islands.size(), -1);
+        for (int y = 0; y < islandRasterHeight; y++)
+        {
+            for (int x = 0; x < islandRasterWidth; x++)
+            {
+                int value = islandRaster[y * islandRasterWidth + x];
+                if (value == 0 || (size_t)value > islands.size()) continue;
+                minX[value - 1] = std::min(minX[value - 1], x);
+                minY[value - 1] = std::min(minY[value - 1], y);
+                maxX[value - 1] = std::max(maxX[value - 1], x);
+                maxY[value - 1] = std::max(maxY[value - 1], y);
+            }
+        }
+
+        entry.seed = perlinSeed;
+        entry.mapSize = mapSize;
+        entry.tolerance = outlineTolerance;
+        entry.outlines.assign(islands.size(), {});
+        ParallelFor(0, islands.size(), 1,
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; i++)
+                        {
+                            if (maxX[i] == -1) continue;
+                            entry.outlines[i] = SimplifyOutline(
+                                TraceIsland(i, minX[i], minY[i], maxX[i], maxY[i]),
+                                outlineTolerance);
+                        }
+                    });
+    }
+
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        islands[i].outline = entry.outlines[i];
+        islands[i].center = islands[i].outline.size() >= 3
+                                ? GetPolygonCentroid(islands[i].outline)
+                                : (islands[i].p1 + islands[i].p2) / 2;
+    }
+}
+
+size_t GetOutlineMemory()
+{
+    return MemoryOf(outlineCache.outlines) + MemoryOf(outlineField);
+}
+
+float DistanceToSegment(Vector2 p, Vector2 a, Vector2 b)
+{
+    Vector2 ab = b - a;
+    float lengthSqr = Vector2LengthSqr(ab);
+    if (lengthSqr == 0) return Vector2Distance(p, a);
+    float t = Clamp(Vector2DotProduct(p - a, ab) / lengthSqr, 0, 1);
+    return Vector2Distance(p, a + ab * t);
+}
+
+void SimplifyRange(const std::vector<Vector2>& points, size_t first, size_t last, float tolerance,
+                   std::vector<uint8_t>& keep)
+{
+    // Douglas-Peucker: keep the farthest point and split there
+    float maxDistance = 0;
+    size_t farthest = first;
+    for (size_t i = first + 1; i < last; i++)
+    {
+        float distance = DistanceToSegment(points[i], points[first], points[last]);
+        if (distance > maxDistance)
+        {
+            maxDistance = distance;
+            farthest = i;
+        }
+    }
+    if (maxDistance <= tolerance) return;
+    keep[farthest] = true;
+    SimplifyRange(points, first, farthest, tolerance, keep);
+    SimplifyRange(points, farthest, last, tolerance, keep);
+}
+
+std::vector<Vector2> SimplifyOutline(const std::vector<Vector2>& points, float tolerance)
+{
+    if (points.size() < 4 || tolerance <= 0) return points;
+
+    // A closed polygon is split at the point farthest from the first one
+    size_t farthest = 0;
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        if (Vector2DistanceSqr(points[i], points[0]) >
+            Vector2DistanceSqr(points[farthest], points[0]))
+            farthest = i;
+    }
+
+    std::vector<Vector2> closed = points;
+    closed.push_back(points[0]);
+    std::vector<uint8_t> keep(closed.size(), false);
+    keep[0] = keep[farthest] = true;
+    SimplifyRange(closed, 0, farthest, tolerance, keep);
+    SimplifyRange(closed, farthest, closed.size() - 1, tolerance, keep);
+
+    std::vector<Vector2> result;
+    for (size_t i = 0; i + 1 < closed.size(); i++)
+    {
+        if (keep[i]) result.push_back(closed[i]);
+    }
+    return result.size() >= 3 ? result : points;
+}
+
+Vector2 GetPolygonCentroid(const std::vector<Vector2>& polygon)
+{
+    float area = 0;
+    Vector2 sum = {0, 0};
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+    {
+        float cross = polygon[j].x * polygon[i].y - polygon[i].x * polygon[j].y;
+        area += cross;
+        sum += (polygon[j] + polygon[i]) * cross;
+    }
+    if (area == 0) return polygon[0];
+    return sum / (3 * area);
+}
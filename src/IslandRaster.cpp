@@ -0,0 +1,196 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "IslandRaster.hpp"
+#include "Island.hpp"
+#include "Jobs.hpp"
+#include "LandMask.hpp"
+#include "Metrics.hpp"
+#include "Perlin.hpp"
+#include "Settings.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+std::vector<uint16_t> islandRaster;
+int islandRasterWidth = 0, islandRasterHeight = 0;
+Vector2 islandRasterOrigin = {0, 0};
+
+std::vector<uint32_t> islandCells, islandCellStart;
+int islandCellsSeed = -1;
+Vector2 islandCellsMapSize = {0, 0};
+
+void ResizeIslandRaster()
+{
+    islandRasterWidth = mapSize.x * ISLAND_RASTER_RES;
+    islandRasterHeight = mapSize.y * ISLAND_RASTER_RES;
+    islandRasterOrigin = {-mapSize.x / 2, -mapSize.y / 2};
+    islandRaster.assign((size_t)islandRasterWidth * islandRasterHeight, 0);
+}
+
+void RebuildIslandRaster()
+{
+    ResizeIslandRaster();
+    const int width = islandRasterWidth, height = islandRasterHeight;
+    const float cellSize = 1.0f / ISLAND_RASTER_RES;
+
+    std::vector<uint8_t> land((size_t)width * height);
+    ParallelFor(0, height, 16,
+                [&land, width, cellSize](size_t begin, size_t end)
+                {
+                    for (size_t y = begin; y < end; y++)
+                    {
+                        for (int x = 0; x < width; x++)
+                        {
+                            Vector2 center = {islandRasterOrigin.x + (x + 0.5f) * cellSize,
+                                              islandRasterOrigin.y + (y + 0.5f) * cellSize};
+                            land[y * width + x] = GetPerlin(center) >= LAND_START;
+                        }
+                    }
+                    AddMetric(Metric::NoiseEvaluations, (end - begin) * width);
+                });
+
+    // Label the land parts, 4-connected like in BuildIslands
+    std::vector<int> components(land.size(), -1);
+    std::vector<std::pair<Vector2, Vector2>> corners;
+    std::vector<int> stack;
+    for (size_t start = 0; start < land.size(); start++)
+    {
+        if (!land[start] || components[start] != -1) continue;
+        int label = corners.size();
+        corners.push_back({{FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX}});
+        components[start] = label;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            int cell = stack.back();
+            stack.pop_back();
+            int x = cell % width, y = cell / width;
+            Vector2 pos = {islandRasterOrigin.x + (x + 0.5f) * cellSize,
+                           islandRasterOrigin.y + (y + 0.5f) * cellSize};
+            corners[label].first = {fminf(corners[label].first.x, pos.x),
+                                    fminf(corners[label].first.y, pos.y)};
+            corners[label].second = {fmaxf(corners[label].second.x, pos.x),
+                                     fmaxf(corners[label].second.y, pos.y)};
+
+            const int neighbours[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+            for (auto& offset: neighbours)
+            {
+                int nx = x + offset[0], ny = y + offset[1];
+                if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                int next = ny * width + nx;
+                if (!land[next] || components[next] != -1) continue;
+                components[next] = label;
+                stack.push_back(next);
+            }
+        }
+    }
+
+    // Every island gets the part with the closest bounding box
+    std::vector<uint16_t> islandOf(corners.size(), 0);
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        int best = -1;
+        float bestDistance = FLT_MAX;
+        for (size_t label = 0; label < corners.size(); label++)
+        {
+            auto& [first, second] = corners[label];
+            float distance = fabsf(first.x - islands[i].p1.x) + fabsf(first.y - islands[i].p1.y) +
+                             fabsf(second.x - islands[i].p2.x) +
+                             fabsf(second.y - islands[i].p2.y);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = label;
+            }
+        }
+        if (best != -1) islandOf[best] = i + 1;
+    }
+
+    for (size_t cell = 0; cell < components.size(); cell++)
+    {
+        if (components[cell] != -1) islandRaster[cell] = islandOf[components[cell]];
+    }
+}
+
+void BuildIslandCells()
+{
+    // Both grids start at the same corner, so a raster cell covers a square of mask cells
+    static_assert(LAND_MASK_RES % ISLAND_RASTER_RES == 0);
+    const int scale = LAND_MASK_RES / ISLAND_RASTER_RES;
+    auto islandOfCell = [scale](int x, int y)
+    { return islandRaster[(y / scale) * islandRasterWidth + x / scale]; };
+
+    islandCellStart.assign(islands.size() + 2, 0);
+    for (int y = 0; y < landMaskHeight; y++)
+    {
+        for (int x = 0; x < landMaskWidth; x++)
+        {
+            if (landMask[y * landMaskWidth + x]) islandCellStart[islandOfCell(x, y) + 1]++;
+        }
+    }
+    for (size_t i = 1; i < islandCellStart.size(); i++)
+    {
+        islandCellStart[i] += islandCellStart[i - 1];
+    }
+
+    // Water of the raster is slot 0, so island i ends up at i + 1
+    std::vector<uint32_t> next(islandCellStart.begin(), islandCellStart.end() - 1);
+    islandCells.resize(islandCellStart.back());
+    for (int y = 0; y < landMaskHeight; y++)
+    {
+        for (int x = 0; x < landMaskWidth; x++)
+        {
+            if (landMask[y * landMaskWidth + x])
+                islandCells[next[islandOfCell(x, y)]++] = y * landMaskWidth + x;
+        }
+    }
+    islandCellStart.erase(islandCellStart.begin());
+
+    islandCellsSeed = perlinSeed;
+    islandCellsMapSize = mapSize;
+}
+
+bool GetRandomIslandPoint(int islandIdx, Vector2& pos)
+{
+    if (islandCellsSeed != perlinSeed || islandCellsMapSize.x != mapSize.x ||
+        islandCellsMapSize.y != mapSize.y)
+        return false;
+    if (islandIdx < 0 || (size_t)islandIdx + 1 >= islandCellStart.size()) return false;
+    uint32_t begin = islandCellStart[islandIdx], end = islandCellStart[islandIdx + 1];
+    if (begin == end) return false;
+
+    uint32_t cell = islandCells[begin + GetThreadRng().NextInt(end - begin)];
+    const float cellSize = 1.0f / LAND_MASK_RES;
+    pos.x = landMaskOrigin.x + (cell % landMaskWidth + GetRandomFloat(0, 1)) * cellSize;
+    pos.y = landMaskOrigin.y + (cell / landMaskWidth + GetRandomFloat(0, 1)) * cellSize;
+    return true;
+}
+
+Json IslandRasterToJSON(const std::vector<uint16_t>& raster)
+{
+    Json json;
+    json.format = JsonFormat::Inline;
+    for (size_t i = 0; i < raster.size();)
+    {
+        size_t run = 1;
+        while (i + run < raster.size() && raster[i + run] == raster[i])
+            run++;
+        json.push_back(raster[i]);
+        json.push_back((int)run);
+        i += run;
+    }
+    return json;
+}
+
+std::vector<uint16_t> IslandRasterFromJSON(Json& json)
+{
+    std::vector<uint16_t> raster;
+    for (size_t i = 0; i + 1 < json.size(); i += 2)
+    {
+        raster.insert(raster.end(), json[i + 1].GetInt(), json[i].GetInt());
+    }
+    return raster;
+}
@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Jobs.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job
+{
+    std::function<void()> func;
+    JobGroup* group = nullptr;
+};
+
+struct JobQueue
+{
+    std::mutex mutex;
+    // Unlike a deque, a vector keeps its memory, so queuing jobs every frame doesn't allocate.
+    // The oldest job is at head, the slots before it are freed once they are half of the vector
+    std::vector<Job> jobs;
+    size_t head = 0;
+
+    bool IsEmpty() const { return head == jobs.size(); }
+
+    // After a job was taken
+    void Compact()
+    {
+        if (IsEmpty())
+        {
+            jobs.clear();
+            head = 0;
+        }
+        else if (head * 2 >= jobs.size())
+        {
+            jobs.erase(jobs.begin(), jobs.begin() + head);
+            head = 0;
+        }
+    }
+};
+
+std::vector<std::thread> workers;
+// One queue per worker and a shared one for every other thread at the end
+std::vector<std::unique_ptr<JobQueue>> jobQueues;
+std::atomic<int> queuedJobs{0};
+std::atomic<bool> jobsRunning{false};
+std::mutex sleepMutex;
+std::condition_variable sleepCondition;
+
+thread_local int workerIndex = -1;
+
+void FinishJob(JobGroup* group, std::exception_ptr error)
+{
+    if (error)
+    {
+        std::lock_guard<std::mutex> lock(group->errorMutex);
+        if (!group->error) group->error = error;
+    }
+    group->pending--;
+}
+
+void PushJob(Job&& job)
+{
+    auto& queue = *jobQueues[workerIndex >= 0 ? workerIndex : jobQueues.size() - 1];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    queuedJobs++;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+}
+
+bool TakeJob(JobQueue& queue, Job& job, JobGroup* group, bool newest)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.IsEmpty()) return false;
+    if (!group)
+    {
+        if (newest)
+        {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(queue.jobs[queue.head++]);
+        }
+        queue.Compact();
+        queuedJobs--;
+        return true;
+    }
+    for (size_t i = queue.head; i < queue.jobs.size(); i++)
+    {
+        if (queue.jobs[i].group != group) continue;
+        // The oldest job fills the hole, so nothing is moved along
+        job = std::move(queue.jobs[i]);
+        if (i != queue.head) queue.jobs[i] = std::move(queue.jobs[queue.head]);
+        queue.head++;
+        queue.Compact();
+        queuedJobs--;
+        return true;
+    }
+    return false;
+}
+
+// Own queue newest first while the data is still warm, then steal the oldest jobs of the others.
+// A non-null group only takes that group's jobs, so waiting never picks up unrelated long work
+bool PopJob(Job& job, JobGroup* group = nullptr)
+{
+    if (jobQueues.empty()) return false;
+    size_t count = jobQueues.size();
+    size_t self = workerIndex >= 0 ? workerIndex : count - 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (TakeJob(*jobQueues[(self + i) % count], job, group, i == 0)) return true;
+    }
+    return false;
+}
+
+// An exception leaving a worker would terminate the game, so it's handed to the group instead
+void RunJob(Job& job)
+{
+    std::exception_ptr error;
+    try
+    {
+        job.func();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    if (job.group) FinishJob(job.group, error);
+}
+
+void WorkerLoop(int idx)
+{
+    workerIndex = idx;
+    while (true)
+    {
+        Job job;
+        if (PopJob(job))
+        {
+            RunJob(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [] { return queuedJobs > 0 || !jobsRunning; });
+        if (!jobsRunning && queuedJobs == 0) return;
+    }
+}
+
+void JobGroup::Run(std::function<void()> job)
+{
+    if (jobQueues.empty())
+    {
+        job();
+        return;
+    }
+    pending++;
+    PushJob({std::move(job), this});
+}
+
+void JobGroup::Wait()
+{
+    WaitJobs();
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (!error) return;
+    std::exception_ptr thrown = error;
+    error = nullptr;
+    std::rethrow_exception(thrown);
+}
+
+void JobGroup::WaitJobs()
+{
+    while (pending > 0)
+    {
+        Job job;
+        if (PopJob(job, this))
+            RunJob(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void InitJobs(int workerCount)
+{
+    if (!workers.empty()) return;
+    if (workerCount <= 0) workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+    for (int i = 0; i <= workerCount; i++)
+    {
+        jobQueues.push_back(std::make_unique<JobQueue>());
+    }
+    jobsRunning = true;
+    for (int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(WorkerLoop, i);
+    }
+}
+
+void ShutdownJobs()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        jobsRunning = false;
+    }
+    sleepCondition.notify_all();
+    for (auto& worker: workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+    jobQueues.clear();
+}
+
+int GetWorkerCount() { return workers.size(); }
+
+void ParallelFor(size_t begin, size_t end, size_t grain,
+                 const std::function<void(size_t, size_t)>& body)
+{
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+    if (end - begin <= grain || jobQueues.empty())
+    {
+        body(begin, end);
+        return;
+    }
+
+    // The jobs capture two words, so std::function keeps them in place instead of allocating
+    struct Range
+    {
+        const std::function<void(size_t, size_t)>* body;
+        size_t end, grain;
+    } range{&body, end, grain};
+    JobGroup group;
+    for (size_t start = begin + grain; start < end; start += grain)
+    {
+        group.Run([&range, start]
+                  { (*range.body)(start, std::min(range.end, start + range.grain)); });
+    }
+    body(begin, begin + grain);
+    group.Wait();
+}
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include "Json.hpp"
+#include "MemoryStats.hpp"
 #include <charconv>
 #include <climits>
 #include <fstream>
@@ -340,6 +341,32 @@ std::string Json::ToString(size_t level) const
     return str;
 }
 
+size_t Json::MemoryUsage() const
+{
+    size_t bytes = 0;
+    if (IsString())
+        bytes = MemoryOf(std::get<std::string>(value));
+    else if (IsArray())
+    {
+        const auto& arr = std::get<array_t>(value);
+        bytes = MemoryOf(arr);
+        for (const auto& item: arr)
+        {
+            bytes += item.MemoryUsage();
+        }
+    }
+    else if (IsObject())
+    {
+        const auto& obj = std::get<object_t>(value);
+        bytes = MemoryOf(obj);
+        for (const auto& [key, item]: obj)
+        {
+            bytes += MemoryOf(key) + item.MemoryUsage();
+        }
+    }
+    return bytes;
+}
+
 void Json::Save(const std::filesystem::path& path)
 {
     std::ofstream f(path);
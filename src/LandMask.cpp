@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "LandMask.hpp"
+#include "Island.hpp"
+#include "Jobs.hpp"
+#include "Metrics.hpp"
+#include "Perlin.hpp"
+#include "Settings.hpp"
+
+std::vector<uint8_t> landMask;
+int landMaskWidth = 0, landMaskHeight = 0;
+Vector2 landMaskOrigin = {0, 0};
+
+void BuildLandMask()
+{
+    landMaskWidth = mapSize.x * LAND_MASK_RES;
+    landMaskHeight = mapSize.y * LAND_MASK_RES;
+    landMaskOrigin = {-mapSize.x / 2, -mapSize.y / 2};
+    landMask.assign((size_t)landMaskWidth * landMaskHeight, 0);
+
+    const float cellSize = 1.0f / LAND_MASK_RES;
+    ParallelFor(0, landMaskHeight, 16,
+                [cellSize](size_t begin, size_t end)
+                {
+                    for (size_t y = begin; y < end; y++)
+                    {
+                        for (int x = 0; x < landMaskWidth; x++)
+                        {
+                            Vector2 center = {landMaskOrigin.x + (x + 0.5f) * cellSize,
+                                              landMaskOrigin.y + (y + 0.5f) * cellSize};
+                            landMask[y * landMaskWidth + x] = GetPerlin(center) >= LAND_START;
+                        }
+                    }
+                    AddMetric(Metric::NoiseEvaluations, (end - begin) * landMaskWidth);
+                });
+}
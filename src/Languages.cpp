@@ -11,6 +11,8 @@
 std::string currentLanguage = "en";
 std::vector<std::string> languages;
 std::unordered_map<std::string, std::string> labels;
+// Points into labels, their nodes don't move when the map grows
+std::unordered_map<std::string_view, const char*> labelIndex;
 
 void GetAllLanguages()
 {
@@ -25,6 +27,7 @@ void GetAllLanguages()
 void ReloadLabels()
 {
     labels.clear();
+    labelIndex.clear();
     std::ifstream englishFile("resources/languages/en.txt"),
         targetFile("resources/languages/" + currentLanguage + ".txt");
     if (!englishFile || !targetFile) return;
@@ -33,9 +36,19 @@ void ReloadLabels()
     {
         labels[enBuf] = targetBuf;
     }
+    for (auto& [key, label]: labels)
+    {
+        labelIndex[key] = label.c_str();
+    }
 
     for (auto& slot: saveSlots)
     {
         if (slot.seed == -1) slot.name = labels["Empty slot"];
     }
 }
+
+const char* GetLabel(std::string_view key)
+{
+    auto it = labelIndex.find(key);
+    return it == labelIndex.end() ? "" : it->second;
+}
@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "MemoryStats.hpp"
+#include "Drawing.hpp"
+#include "Human.hpp"
+#include "Island.hpp"
+#include "IslandOutline.hpp"
+#include "IslandRaster.hpp"
+#include "LandMask.hpp"
+#include "Pathfinding.hpp"
+#include "Progress.hpp"
+#include "Ship.hpp"
+#include "Terrain.hpp"
+#include <algorithm>
+#include <iostream>
+#include <raylib.h>
+
+#define SUBSYSTEM_COUNT (int)MemorySubsystem::Count
+
+const char* memorySubsystemNames[SUBSYSTEM_COUNT + 1] = {
+    "pathMap", "routes", "islands", "people", "ships",
+    "saveSlots", "json", "font", "textures", "total",
+};
+
+bool memoryStatsEnabled = false;
+
+// The total is kept after the subsystems
+size_t memoryUsage[SUBSYSTEM_COUNT + 1] = {};
+size_t peakMemoryUsage[SUBSYSTEM_COUNT + 1] = {};
+
+size_t MemoryOf(const std::vector<Island>& islands)
+{
+    size_t bytes = islands.capacity() * sizeof(Island);
+    for (auto& island: islands)
+    {
+        bytes += MemoryOf(island.outline);
+    }
+    return bytes;
+}
+
+size_t MemoryOf(const Texture& texture)
+{
+    return GetPixelDataSize(texture.width, texture.height, texture.format);
+}
+
+size_t GetIslandMemory()
+{
+    return MemoryOf(islands) + MemoryOf(populationHeap.heap) + MemoryOf(populationHeap.position) +
+           MemoryOf(islandRaster) + MemoryOf(islandCells) + MemoryOf(islandCellStart) +
+           MemoryOf(landMask) + GetOutlineMemory();
+}
+
+size_t GetSaveSlotMemory()
+{
+    size_t bytes = saveSlots.capacity() * sizeof(SaveSlot);
+    for (auto& slot: saveSlots)
+    {
+        bytes += MemoryOf(slot.name) + MemoryOf(slot.islands) + MemoryOf(slot.people) +
+                 MemoryOf(slot.ships) + MemoryOf(slot.islandRaster);
+    }
+    return bytes;
+}
+
+size_t GetFontMemory()
+{
+    // Glyph images are kept on the CPU next to the atlas
+    size_t bytes = MemoryOf(myFont.texture);
+    if (myFont.glyphs)
+    {
+        for (int i = 0; i < myFont.glyphCount; i++)
+        {
+            const Image& image = myFont.glyphs[i].image;
+            bytes += GetPixelDataSize(image.width, image.height, image.format);
+        }
+        bytes += myFont.glyphCount * sizeof(GlyphInfo);
+    }
+    if (myFont.recs) bytes += myFont.glyphCount * sizeof(Rectangle);
+    return bytes;
+}
+
+void UpdatePeaks()
+{
+    size_t total = 0;
+    for (int i = 0; i < SUBSYSTEM_COUNT; i++)
+    {
+        total += memoryUsage[i];
+        peakMemoryUsage[i] = std::max(peakMemoryUsage[i], memoryUsage[i]);
+    }
+    memoryUsage[SUBSYSTEM_COUNT] = total;
+    peakMemoryUsage[SUBSYSTEM_COUNT] = std::max(peakMemoryUsage[SUBSYSTEM_COUNT], total);
+}
+
+void UpdateMemoryStats()
+{
+    memoryUsage[(int)MemorySubsystem::PathMap] = GetPathMapMemory();
+    memoryUsage[(int)MemorySubsystem::Routes] = GetRouteMemory();
+    memoryUsage[(int)MemorySubsystem::Islands] = GetIslandMemory();
+    memoryUsage[(int)MemorySubsystem::People] = MemoryOf(people) + MemoryOf(islandPeople);
+    memoryUsage[(int)MemorySubsystem::Ships] = ships.MemoryUsage() + MemoryOf(shipRequests);
+    memoryUsage[(int)MemorySubsystem::SaveSlots] = GetSaveSlotMemory();
+    memoryUsage[(int)MemorySubsystem::Font] = GetFontMemory();
+    memoryUsage[(int)MemorySubsystem::Textures] =
+        MemoryOf(lockTexture) + MemoryOf(woodTexture) + MemoryOf(ironTexture) +
+        MemoryOf(humanTexture) + MemoryOf(shipTexture) + GetTerrainMemory();
+    UpdatePeaks();
+}
+
+void SetMemoryUsage(MemorySubsystem subsystem, size_t bytes)
+{
+    memoryUsage[(int)subsystem] = bytes;
+    UpdatePeaks();
+}
+
+size_t GetMemoryUsage(MemorySubsystem subsystem) { return memoryUsage[(int)subsystem]; }
+
+size_t GetPeakMemoryUsage(MemorySubsystem subsystem) { return peakMemoryUsage[(int)subsystem]; }
+
+const char* GetMemorySubsystemName(MemorySubsystem subsystem)
+{
+    return memorySubsystemNames[(int)subsystem];
+}
+
+Json MemoryStatsToJSON()
+{
+    Json json;
+    for (int i = 0; i <= SUBSYSTEM_COUNT; i++)
+    {
+        Json& subsystem = json[memorySubsystemNames[i]];
+        subsystem.format = JsonFormat::Inline;
+        subsystem["bytes"] = (double)memoryUsage[i];
+        subsystem["peakBytes"] = (double)peakMemoryUsage[i];
+    }
+    return json;
+}
+
+void PrintMemoryStats()
+{
+    for (int i = 0; i <= SUBSYSTEM_COUNT; i++)
+    {
+        std::cout << "memory " << memorySubsystemNames[i] << ": " << memoryUsage[i] / 1024
+                  << " KiB, peak " << peakMemoryUsage[i] / 1024 << " KiB\n";
+    }
+}
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Metrics.hpp"
+#include "Json.hpp"
+#include "Settings.hpp"
+#include "Simulation.hpp"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define METRIC_COUNT (int)Metric::Count
+
+const char* metricNames[METRIC_COUNT] = {
+    "frames",         "noiseEvaluations", "routeCacheHits", "routeCacheMisses",
+    "shipsLaunched",  "growthTicks",      "saveBytes",      "allocations",
+    "allocatedBytes", "people",           "ships",          "colonizedIslands",
+    "scheduledEvents",
+};
+
+// Counters of one thread. Only their thread writes to them, so adding doesn't need a lock
+struct alignas(64) MetricCounters
+{
+    std::atomic<int64_t> values[METRIC_COUNT] = {};
+};
+
+std::mutex metricsMutex;
+std::vector<std::unique_ptr<MetricCounters>> metricCounters;
+// Counters of the threads that have exited, they keep their totals and go to the next new thread
+std::vector<MetricCounters*> freeMetricCounters;
+std::atomic<int64_t> metricGauges[METRIC_COUNT] = {};
+
+int64_t lastMetrics[METRIC_COUNT] = {};
+double lastMetricsTime = 0;
+
+// Gives the counters back when its thread exits
+struct MetricsThread
+{
+    MetricCounters* counters;
+
+    ~MetricsThread()
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex);
+        freeMetricCounters.push_back(counters);
+    }
+};
+
+MetricCounters* AcquireMetricCounters()
+{
+    MetricCounters* counters;
+    {
+        std::lock_guard<std::mutex> lock(metricsMutex);
+        if (!freeMetricCounters.empty())
+        {
+            counters = freeMetricCounters.back();
+            freeMetricCounters.pop_back();
+        }
+        else
+        {
+            metricCounters.push_back(std::make_unique<MetricCounters>());
+            counters = metricCounters.back().get();
+        }
+    }
+    thread_local MetricsThread thread{counters};
+    return counters;
+}
+
+void AddMetric(Metric metric, int64_t amount)
+{
+    // A plain pointer, so counting doesn't go through the thread_local initialization check
+    thread_local MetricCounters* counters = nullptr;
+    if (!counters) counters = AcquireMetricCounters();
+    auto& value = counters->values[(int)metric];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void SetMetric(Metric metric, int64_t value)
+{
+    metricGauges[(int)metric].store(value, std::memory_order_relaxed);
+}
+
+int64_t GetMetric(Metric metric)
+{
+    if (metric >= METRIC_FIRST_GAUGE)
+        return metricGauges[(int)metric].load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(metricsMutex);
+    int64_t total = 0;
+    for (auto& counters: metricCounters)
+    {
+        total += counters->values[(int)metric].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void UpdateMetrics(double time)
+{
+    if (metricsInterval <= 0 || time - lastMetricsTime < metricsInterval) return;
+    lastMetricsTime = time;
+
+    Json json;
+    json.format = JsonFormat::Inline;
+    json["time"] = time;
+    json["simulationTime"] = simulationTime;
+    for (int i = 0; i < METRIC_COUNT; i++)
+    {
+        int64_t value = GetMetric((Metric)i);
+        if (i < (int)METRIC_FIRST_GAUGE)
+        {
+            json[metricNames[i]] = (double)(value - lastMetrics[i]);
+            lastMetrics[i] = value;
+        }
+        else
+            json[metricNames[i]] = (double)value;
+    }
+
+    std::error_code error;
+    if (std::filesystem::file_size(METRICS_PATH, error) > METRICS_FILE_LIMIT && !error)
+        std::filesystem::rename(METRICS_PATH, METRICS_OLD_PATH, error);
+    std::ofstream file(METRICS_PATH, std::ios::app);
+    file << json.ToString() << '\n';
+}
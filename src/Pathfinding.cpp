@@ -4,13 +4,28 @@
 
 #include "Pathfinding.hpp"
 #include "Island.hpp"
+#include "IslandRaster.hpp"
+#include "Jobs.hpp"
+#include "MemoryStats.hpp"
+#include "Metrics.hpp"
 #include "Perlin.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
 #include "Settings.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <queue>
 #include <raymath.h>
+#include <unordered_map>
 
 std::vector<ParentMap> pathMap;
+std::vector<std::vector<int>> islandPorts;
+std::vector<int> seaRegions;
+std::vector<std::vector<int>> islandSeaRegions;
 
 std::vector<Vector2> directions{{0, -1}, {1, -1}, {1, 0},  {1, 1},
                                 {0, 1},  {-1, 1}, {-1, 0}, {-1, -1}};
@@ -34,12 +49,6 @@ Vector2 IntToVector2(int val)
     return {(float)ix - mapSize.x / 2.0f, (float)iy - mapSize.y / 2.0f};
 }
 
-bool IsInsideMap(Vector2 v)
-{
-    return v.x >= -mapSize.x / 2 && v.x < mapSize.x / 2 && v.y >= -mapSize.y / 2 &&
-           v.y < mapSize.y / 2;
-}
-
 struct Node
 {
     int idx;
@@ -47,70 +56,313 @@ struct Node
     bool operator>(const Node& other) const { return cost > other.cost; }
 };
 
-void GeneratePathMap()
+// Land cells of the map used by the background jobs and the line of sight checks. Only rebuilt
+// when none of the jobs is running
+std::vector<uint8_t> pathLand;
+std::unique_ptr<std::atomic<bool>[]> pathReady;
+std::atomic<int> pathGeneration{0};
+JobGroup pathJobs;
+// Keyed by the target island and the port
+std::unordered_map<int64_t, RouteId> routeTable;
+std::vector<Route> routes;
+std::vector<Vector2> routePoints;
+std::vector<float> routeDistances;
+
+// The size of the map is passed in, the globals can change while the job runs and only get
+// consistent again once CancelPathMap returns
+void GenerateIslandPathMap(size_t i, int generation, int width, int height)
 {
-    pathMap.clear();
-    pathMap.resize(islands.size());
+    PROFILE_SCOPE("Island path map");
+    // Cancelled while it was queued, nothing is allocated for it
+    if (pathGeneration != generation) return;
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> pq;
+    std::vector<float> minCosts((size_t)width * height, std::numeric_limits<float>::max());
+    ParentMap parents((size_t)width * height, -1);
 
-    std::vector<bool> onLand(mapSize.x * mapSize.y, false);
-    for (size_t i = 0; i < mapSize.x; i++)
+    // Ships arrive at whichever port of the island is the closest
+    for (int start: islandPorts[i])
     {
-        for (size_t j = 0; j < mapSize.y; j++)
-        {
-            onLand[j * mapSize.x + i] = GetPerlin(IntToVector2(j * mapSize.x + i)) >= LAND_START;
-        }
+        minCosts[start] = 0;
+        pq.push({start, 0});
     }
 
-    for (size_t i = 0; i < islands.size(); i++)
+    size_t steps = 0;
+    while (!pq.empty())
     {
-        auto& island = islands[i];
-        pathMap[i].assign(mapSize.x * mapSize.y, -1);
+        // A newer map was requested, this one won't be used
+        if (++steps % 4096 == 0 && pathGeneration != generation) return;
+
+        Node u = pq.top();
+        pq.pop();
 
-        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> pq;
-        std::vector<float> minCosts(mapSize.x * mapSize.y, std::numeric_limits<float>::max());
+        if (u.cost > minCosts[u.idx]) continue;
 
-        Vector2 startPos = island.GetRandomPoint();
-        Vector2 endPos = {0, 0};
-        Vector2 dir = Vector2Normalize(endPos - startPos);
-        do
+        int x = u.idx % width, y = u.idx / width;
+        for (auto& dir: directions)
         {
-            startPos += dir;
-        } while (onLand[Vector2ToInt(startPos)]);
+            int nx = x + (int)dir.x, ny = y + (int)dir.y;
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            int v = ny * width + nx;
+            if (pathLand[v]) continue;
 
-        auto start = Vector2ToInt(startPos);
-        minCosts[start] = 0;
-        pq.push({start, 0});
+            float moveStep = (dir.x != 0 && dir.y != 0) ? 1.414f : 1.0f;
+            float newCost = u.cost + moveStep;
 
-        while (!pq.empty())
-        {
-            Node u = pq.top();
-            pq.pop();
+            if (newCost < minCosts[v])
+            {
+                minCosts[v] = newCost;
+                parents[v] = u.idx;
+                pq.push({v, newCost});
+            }
+        }
+    }
 
-            if (u.cost > minCosts[u.idx]) continue;
+    pathMap[i] = std::move(parents);
+    pathReady[i].store(true, std::memory_order_release);
+}
 
-            Vector2 uVec = IntToVector2(u.idx);
+void CancelPathMap()
+{
+    pathGeneration++;
+    pathJobs.Wait();
+}
 
-            for (auto& dir: directions)
+void LabelSeaRegions()
+{
+    // Ships can move diagonally, so the water is 8-connected like in GenerateIslandPathMap
+    int width = mapSize.x, height = mapSize.y;
+    seaRegions.assign((size_t)width * height, -1);
+    std::vector<int> stack;
+    int regions = 0;
+    for (int start = 0; start < width * height; start++)
+    {
+        if (pathLand[start] || seaRegions[start] != -1) continue;
+        int region = regions++;
+        seaRegions[start] = region;
+        stack.push_back(start);
+        while (!stack.empty())
+        {
+            int cell = stack.back();
+            stack.pop_back();
+            int x = cell % width, y = cell / width;
+            for (int dy = -1; dy <= 1; dy++)
             {
-                Vector2 vVec = uVec + dir;
-                if (!IsInsideMap(uVec + dir) || onLand[Vector2ToInt(uVec + dir)]) continue;
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    int nx = x + dx, ny = y + dy;
+                    if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                    int next = ny * width + nx;
+                    if (pathLand[next] || seaRegions[next] != -1) continue;
+                    seaRegions[next] = region;
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+}
 
-                int v = Vector2ToInt(vVec);
+void FindPorts()
+{
+    // Coastal water cells of every island, the land next to them tells which island it is
+    int width = mapSize.x, height = mapSize.y;
+    std::vector<std::vector<int>> coast(islands.size());
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int idx = y * width + x;
+            if (pathLand[idx]) continue;
+            const int neighbours[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+            for (auto& offset: neighbours)
+            {
+                int nx = x + offset[0], ny = y + offset[1];
+                if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                if (!pathLand[ny * width + nx]) continue;
+                int islandIdx = IslandAt(IntToVector2(ny * width + nx));
+                if (islandIdx < 0 || (size_t)islandIdx >= islands.size()) continue;
+                coast[islandIdx].push_back(idx);
+                break;
+            }
+        }
+    }
+
+    LabelSeaRegions();
+
+    islandPorts.assign(islands.size(), {});
+    islandSeaRegions.assign(islands.size(), {});
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        auto& ports = islandPorts[i];
+        if (coast[i].empty())
+        {
+            // Not in the raster, start in the water next to a random point like before
+            Rng rng = MakeRng(RngStream::World, i);
+            Rng* lastRng = SetThreadRng(&rng);
+            Vector2 startPos = islands[i].GetRandomPoint();
+            SetThreadRng(lastRng);
+
+            Vector2 dir = Vector2Normalize(Vector2{0, 0} - startPos);
+            do
+            {
+                startPos += dir;
+            } while (pathLand[Vector2ToInt(startPos)]);
+            ports.push_back(Vector2ToInt(startPos));
+            islandSeaRegions[i].push_back(seaRegions[ports.back()]);
+            continue;
+        }
 
-                float moveStep = (dir.x != 0 && dir.y != 0) ? 1.414f : 1.0f;
-                float newCost = u.cost + moveStep;
+        // Every water body the island touches gets its own ports, so the island can be reached
+        // from all of them
+        auto& regions = islandSeaRegions[i];
+        for (int cell: coast[i])
+        {
+            regions.push_back(seaRegions[cell]);
+        }
+        std::sort(regions.begin(), regions.end());
+        regions.erase(std::unique(regions.begin(), regions.end()), regions.end());
 
-                if (newCost < minCosts[v])
+        // The first port is the closest one to the middle of the map, the others are as far from
+        // the rest as possible
+        auto distanceTo = [](int cell, Vector2 pos)
+        { return Vector2DistanceSqr(IntToVector2(cell), pos); };
+        auto closerToMiddle = [&](int a, int b)
+        { return distanceTo(a, {0, 0}) < distanceTo(b, {0, 0}); };
+        std::vector<int> cells;
+        for (int region: regions)
+        {
+            cells.clear();
+            for (int cell: coast[i])
+            {
+                if (seaRegions[cell] == region) cells.push_back(cell);
+            }
+            size_t first = ports.size();
+            ports.push_back(*std::min_element(cells.begin(), cells.end(), closerToMiddle));
+            while (ports.size() - first < std::min<size_t>(PORTS_PER_ISLAND, cells.size()))
+            {
+                int best = cells[0];
+                float bestDistance = -1;
+                for (int cell: cells)
                 {
-                    minCosts[v] = newCost;
-                    pathMap[i][v] = u.idx;
-                    pq.push({v, newCost});
+                    float distance = std::numeric_limits<float>::max();
+                    for (size_t j = first; j < ports.size(); j++)
+                    {
+                        distance = std::min(distance, distanceTo(cell, IntToVector2(ports[j])));
+                    }
+                    if (distance > bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = cell;
+                    }
                 }
+                ports.push_back(best);
             }
         }
     }
 }
 
+void GeneratePathMap()
+{
+    PROFILE_SCOPE("Path map");
+    CancelPathMap();
+    int generation = pathGeneration;
+
+    pathMap.clear();
+    pathMap.resize(islands.size());
+    routeTable.clear();
+    routes.clear();
+    routePoints.clear();
+    routeDistances.clear();
+    pathReady = std::make_unique<std::atomic<bool>[]>(islands.size());
+
+    int width = mapSize.x, height = mapSize.y;
+    pathLand.assign((size_t)width * height, 0);
+    ParallelFor(0, height, 16,
+                [width](size_t begin, size_t end)
+                {
+                    for (size_t j = begin; j < end; j++)
+                    {
+                        for (int i = 0; i < width; i++)
+                        {
+                            int idx = j * width + i;
+                            pathLand[idx] = GetPerlin(IntToVector2(idx)) >= LAND_START;
+                        }
+                    }
+                    AddMetric(Metric::NoiseEvaluations, (end - begin) * width);
+                });
+
+    FindPorts();
+
+    // Islands close to the colonized ones are the likeliest ship targets, so they go first
+    std::vector<Vector2> colonized;
+    for (auto& island: islands)
+    {
+        if (island.colonized) colonized.push_back((island.p1 + island.p2) / 2);
+    }
+    std::vector<std::pair<float, int>> order;
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        Vector2 center = (islands[i].p1 + islands[i].p2) / 2;
+        float distance = std::numeric_limits<float>::max();
+        for (auto& pos: colonized)
+        {
+            distance = std::min(distance, Vector2DistanceSqr(center, pos));
+        }
+        order.push_back({distance, i});
+    }
+    std::sort(order.begin(), order.end());
+
+    // Jobs from the main thread are taken in the order they were added
+    for (auto& [distance, i]: order)
+    {
+        pathJobs.Run([i, generation, width, height]
+                     { GenerateIslandPathMap(i, generation, width, height); });
+    }
+}
+
+bool IsPathMapReady(int islandIdx)
+{
+    if (islandIdx < 0 || (size_t)islandIdx >= pathMap.size()) return false;
+    return pathReady[islandIdx].load(std::memory_order_acquire);
+}
+
+size_t GetPathMapMemory()
+{
+    // The maps that are still being built are written by the jobs, so they aren't looked at
+    size_t bytes = pathMap.capacity() * sizeof(ParentMap);
+    for (size_t i = 0; i < pathMap.size(); i++)
+    {
+        if (IsPathMapReady(i)) bytes += MemoryOf(pathMap[i]);
+    }
+    bytes += pathMap.size() * sizeof(std::atomic<bool>);
+    return bytes + MemoryOf(pathLand) + MemoryOf(islandPorts) + MemoryOf(seaRegions) +
+           MemoryOf(islandSeaRegions);
+}
+
+size_t GetRouteMemory()
+{
+    return MemoryOf(routeTable) + MemoryOf(routes) + MemoryOf(routePoints) +
+           MemoryOf(routeDistances);
+}
+
+bool IsReachable(int sourceIslandIdx, int targetIslandIdx)
+{
+    if ((size_t)sourceIslandIdx >= islandSeaRegions.size() ||
+        (size_t)targetIslandIdx >= islandSeaRegions.size())
+        return false;
+    // Both lists are sorted
+    auto &source = islandSeaRegions[sourceIslandIdx], &target = islandSeaRegions[targetIslandIdx];
+    size_t i = 0, j = 0;
+    while (i < source.size() && j < target.size())
+    {
+        if (source[i] == target[j]) return true;
+        if (source[i] < target[j])
+            i++;
+        else
+            j++;
+    }
+    return false;
+}
+
 Path GetPath(Vector2 startPos, int targetIslandIdx)
 {
     Path path;
@@ -122,3 +374,138 @@ Path GetPath(Vector2 startPos, int targetIslandIdx)
     }
     return path;
 }
+
+bool IsPathLand(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= (int)mapSize.x || y >= (int)mapSize.y) return true;
+    return pathLand[y * (int)mapSize.x + x];
+}
+
+bool IsLineOfSight(Vector2 from, Vector2 to)
+{
+    // Cells are centered on whole coordinates like in Vector2ToInt, shift them to start there
+    float x0 = from.x + mapSize.x / 2 + 0.5f, y0 = from.y + mapSize.y / 2 + 0.5f;
+    float x1 = to.x + mapSize.x / 2 + 0.5f, y1 = to.y + mapSize.y / 2 + 0.5f;
+    int x = floorf(x0), y = floorf(y0);
+    int endX = floorf(x1), endY = floorf(y1);
+
+    // Walk through every cell the segment touches
+    const float infinity = std::numeric_limits<float>::infinity();
+    float dx = x1 - x0, dy = y1 - y0;
+    int stepX = dx > 0 ? 1 : -1, stepY = dy > 0 ? 1 : -1;
+    float deltaX = dx != 0 ? fabsf(1 / dx) : infinity, deltaY = dy != 0 ? fabsf(1 / dy) : infinity;
+    float maxX = dx > 0 ? (x + 1 - x0) * deltaX : dx < 0 ? (x0 - x) * deltaX : infinity;
+    float maxY = dy > 0 ? (y + 1 - y0) * deltaY : dy < 0 ? (y0 - y) * deltaY : infinity;
+
+    for (int steps = abs(endX - x) + abs(endY - y); steps >= 0; steps--)
+    {
+        if (IsPathLand(x, y)) return false;
+        if (maxX < maxY)
+        {
+            x += stepX;
+            maxX += deltaX;
+        }
+        else if (maxY < maxX)
+        {
+            y += stepY;
+            maxY += deltaY;
+        }
+        else if (steps > 0)
+        {
+            // Exactly through a corner, ships can't squeeze between two land cells
+            if (IsPathLand(x + stepX, y) || IsPathLand(x, y + stepY)) return false;
+            x += stepX;
+            y += stepY;
+            maxX += deltaX;
+            maxY += deltaY;
+            steps--;
+        }
+    }
+    return true;
+}
+
+Path SmoothPath(const Path& path)
+{
+    if (path.size() <= 2) return path;
+
+    Path smooth{path[0]};
+    size_t anchor = 0;
+    for (size_t i = 2; i < path.size(); i++)
+    {
+        if (IsLineOfSight(path[anchor], path[i])) continue;
+        anchor = i - 1;
+        smooth.push_back(path[anchor]);
+    }
+    smooth.push_back(path.back());
+    return smooth;
+}
+
+RouteId GetRoute(int sourceIslandIdx, int targetIslandIdx)
+{
+    const Island& target = islands[targetIslandIdx];
+    auto& targetRegions = islandSeaRegions[targetIslandIdx];
+    int port = -1;
+    float portDistance = std::numeric_limits<float>::max();
+    for (int other: islandPorts[sourceIslandIdx])
+    {
+        // Only ports in the water of the target's ports lead anywhere
+        if (std::find(targetRegions.begin(), targetRegions.end(), seaRegions[other]) ==
+            targetRegions.end())
+            continue;
+        float distance = Vector2DistanceSqr(IntToVector2(other), target.center);
+        if (distance < portDistance)
+        {
+            portDistance = distance;
+            port = other;
+        }
+    }
+    if (port == -1) return NO_ROUTE;
+
+    int64_t key = (int64_t)targetIslandIdx << 32 | port;
+    auto it = routeTable.find(key);
+    if (it != routeTable.end())
+    {
+        AddMetric(Metric::RouteCacheHits);
+        return it->second;
+    }
+    AddMetric(Metric::RouteCacheMisses);
+
+    Path path = SmoothPath(GetPath(IntToVector2(port), targetIslandIdx));
+    Route route;
+    route.first = routePoints.size();
+    route.count = path.size();
+    route.minX = route.maxX = path[0].x;
+    route.minY = route.maxY = path[0].y;
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        if (i > 0) route.length += Vector2Distance(path[i - 1], path[i]);
+        routeDistances.push_back(route.length);
+        route.minX = std::min(route.minX, path[i].x);
+        route.minY = std::min(route.minY, path[i].y);
+        route.maxX = std::max(route.maxX, path[i].x);
+        route.maxY = std::max(route.maxY, path[i].y);
+    }
+    routePoints.insert(routePoints.end(), path.begin(), path.end());
+
+    RouteId id = routes.size();
+    routes.push_back(route);
+    routeTable.emplace(key, id);
+    return id;
+}
+
+Vector2 GetRoutePoint(RouteId id, float distance, int* flip)
+{
+    const Route& route = routes[id];
+    const float* distances = routeDistances.data() + route.first;
+    const Vector2* points = routePoints.data() + route.first;
+    if (route.count == 1 || distance <= 0) return points[0];
+
+    // First point further than distance, the point is on the segment before it
+    size_t next = std::upper_bound(distances, distances + route.count, distance) - distances;
+    if (next >= route.count) next = route.count - 1;
+    Vector2 from = points[next - 1], to = points[next];
+    if (flip) *flip = to.x - from.x < -0.1f ? -1 : 1;
+    float segment = distances[next] - distances[next - 1];
+    if (segment <= 0) return to;
+    return Vector2Lerp(from, to, std::min(1.0f, (distance - distances[next - 1]) / segment));
+}
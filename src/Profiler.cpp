@@ -0,0 +1,301 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include "Json.hpp"
+#include "MemoryStats.hpp"
+#include "Metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <raylib.h>
+#include <string>
+#include <vector>
+
+// Allocations of one thread. Threads past PROFILER_MAX_THREADS share the last counters, so they
+// are added to atomically
+struct alignas(64) AllocationCounters
+{
+    std::atomic<uint64_t> count{0}, bytes{0};
+};
+
+AllocationCounters allocationCounters[PROFILER_MAX_THREADS];
+std::atomic<int> allocationThreads{0};
+
+AllocationCounters& ThreadAllocationCounters()
+{
+    // A plain int, so it is usable from operator new before anything else on the thread
+    thread_local int thread = -1;
+    if (thread < 0) thread = std::min(allocationThreads++, PROFILER_MAX_THREADS - 1);
+    return allocationCounters[thread];
+}
+
+void* CountedAlloc(size_t size)
+{
+    auto& counters = ThreadAllocationCounters();
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+    void* ptr = CountedAlloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+AllocationCount GetThreadAllocations()
+{
+    auto& counters = ThreadAllocationCounters();
+    return {counters.count.load(std::memory_order_relaxed),
+            counters.bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationCount GetTotalAllocations()
+{
+    AllocationCount total;
+    for (auto& counters: allocationCounters)
+    {
+        total.count += counters.count.load(std::memory_order_relaxed);
+        total.bytes += counters.bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+struct ProfileSection
+{
+    std::string name;
+    bool counter = false;
+    // Milliseconds or the counted value of the current frame and of the last one
+    double total = 0, last = 0;
+    int calls = 0, lastCalls = 0;
+    AllocationCount allocations, lastAllocations;
+};
+
+struct TraceEvent
+{
+    int section;
+    int thread;
+    // Microseconds since the start of the game, the duration is the value for counters
+    double start, duration;
+};
+
+std::mutex profilerMutex;
+std::vector<ProfileSection> profileSections;
+std::vector<TraceEvent> traceEvents;
+bool showProfiler = false;
+bool tracing = false;
+int threadCount = 0;
+
+double frameTimes[PROFILER_HISTORY];
+size_t frameCount = 0;
+AllocationCount frameAllocations, lastFrameAllocations;
+
+const auto profilerStart = std::chrono::steady_clock::now();
+double lastFrame = 0;
+
+double ProfilerNow()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                     profilerStart)
+        .count();
+}
+
+int ProfilerThread()
+{
+    thread_local int thread = -1;
+    if (thread < 0)
+    {
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        thread = threadCount++;
+    }
+    return thread;
+}
+
+int GetProfileSection(const char* name, bool counter)
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    for (size_t i = 0; i < profileSections.size(); i++)
+    {
+        if (profileSections[i].name == name) return i;
+    }
+    profileSections.push_back({});
+    profileSections.back().name = name;
+    profileSections.back().counter = counter;
+    return profileSections.size() - 1;
+}
+
+ProfileScope::ProfileScope(int section)
+    : section(section), start(ProfilerNow()), allocations(GetThreadAllocations())
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+    double duration = ProfilerNow() - start;
+    AllocationCount end = GetThreadAllocations();
+    int thread = ProfilerThread();
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    profileSections[section].total += duration / 1000;
+    profileSections[section].calls++;
+    profileSections[section].allocations.count += end.count - allocations.count;
+    profileSections[section].allocations.bytes += end.bytes - allocations.bytes;
+    if (tracing && traceEvents.size() < PROFILER_TRACE_LIMIT)
+        traceEvents.push_back({section, thread, start, duration});
+}
+
+void ProfileCount(int section, double value)
+{
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    profileSections[section].total += value;
+    profileSections[section].calls++;
+}
+
+void ProfileFrame()
+{
+    double now = ProfilerNow();
+    frameTimes[frameCount++ % PROFILER_HISTORY] = (now - lastFrame) / 1000;
+    lastFrame = now;
+
+    AllocationCount allocations = GetTotalAllocations();
+    lastFrameAllocations.count = allocations.count - frameAllocations.count;
+    lastFrameAllocations.bytes = allocations.bytes - frameAllocations.bytes;
+    frameAllocations = allocations;
+    AddMetric(Metric::Allocations, lastFrameAllocations.count);
+    AddMetric(Metric::AllocatedBytes, lastFrameAllocations.bytes);
+    PROFILE_COUNT("Allocations", lastFrameAllocations.count);
+    PROFILE_COUNT("Allocated bytes", lastFrameAllocations.bytes);
+
+    {
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        for (size_t i = 0; i < profileSections.size(); i++)
+        {
+            auto& section = profileSections[i];
+            if (tracing && section.counter && traceEvents.size() < PROFILER_TRACE_LIMIT)
+                traceEvents.push_back({(int)i, 0, now, section.total});
+            section.last = section.total;
+            section.lastCalls = section.calls;
+            section.lastAllocations = section.allocations;
+            section.total = 0;
+            section.calls = 0;
+            section.allocations = {};
+        }
+    }
+
+    if (IsKeyPressed(KEY_F3)) memoryStatsEnabled = showProfiler = !showProfiler;
+    if (showProfiler) UpdateMemoryStats();
+    if (IsKeyPressed(KEY_F4))
+    {
+        if (tracing) SaveProfilerTrace(PROFILER_TRACE_PATH);
+        std::lock_guard<std::mutex> lock(profilerMutex);
+        tracing = !tracing;
+        traceEvents.clear();
+    }
+}
+
+// Line i of the overlay, -1 when there are no more. Formatted with TextFormat, so drawing the
+// overlay doesn't allocate
+const char* GetProfilerLine(int i, double p50, double p99)
+{
+    if (i == 0) return TextFormat("frame p50 %.2f ms p99 %.2f ms", p50, p99);
+    if (i == 1)
+        return TextFormat("allocations %llu, %llu bytes",
+                          (unsigned long long)lastFrameAllocations.count,
+                          (unsigned long long)lastFrameAllocations.bytes);
+    i -= 2;
+    if (i <= (int)MemorySubsystem::Count)
+    {
+        auto subsystem = (MemorySubsystem)i;
+        return TextFormat("memory %s %.1f MB, peak %.1f MB", GetMemorySubsystemName(subsystem),
+                          GetMemoryUsage(subsystem) / 1048576.0,
+                          GetPeakMemoryUsage(subsystem) / 1048576.0);
+    }
+    i -= (int)MemorySubsystem::Count + 1;
+    if (tracing && i == 0) return "recording trace (F4 to save)";
+    size_t idx = i - (tracing ? 1 : 0);
+    if (idx >= profileSections.size()) return nullptr;
+
+    auto& section = profileSections[idx];
+    if (section.counter) return TextFormat("%s %.0f", section.name.c_str(), section.last);
+    return TextFormat("%s %.2f ms x%d, %llu allocs", section.name.c_str(), section.last,
+                      section.lastCalls, (unsigned long long)section.lastAllocations.count);
+}
+
+void DrawProfiler()
+{
+    if (!showProfiler) return;
+
+    size_t count = std::min(frameCount, (size_t)PROFILER_HISTORY);
+    double sorted[PROFILER_HISTORY];
+    std::copy(frameTimes, frameTimes + count, sorted);
+    std::sort(sorted, sorted + count);
+    double p50 = count > 0 ? sorted[count / 2] : 0;
+    double p99 = count > 0 ? sorted[count * 99 / 100] : 0;
+
+    const int fontSize = 20, margin = 10;
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    int width = 0, lines = 0;
+    for (const char* line; (line = GetProfilerLine(lines, p50, p99)); lines++)
+    {
+        width = std::max(width, MeasureText(line, fontSize));
+    }
+    int height = lines * fontSize;
+    int x = GetScreenWidth() - width - margin * 3, y = margin * 6;
+    DrawRectangle(x, y, width + margin * 2, height + margin * 2, {0, 0, 0, 160});
+    for (int i = 0; i < lines; i++)
+    {
+        DrawText(GetProfilerLine(i, p50, p99), x + margin, y + margin + i * fontSize, fontSize,
+                 WHITE);
+    }
+}
+
+void SaveProfilerTrace(const char* path)
+{
+    Json json;
+    json["displayTimeUnit"] = "ms";
+    json["traceEvents"] = Json::array_t();
+
+    std::lock_guard<std::mutex> lock(profilerMutex);
+    for (auto& event: traceEvents)
+    {
+        const auto& section = profileSections[event.section];
+        Json entry;
+        entry.format = JsonFormat::Inline;
+        entry["name"] = section.name;
+        entry["ph"] = section.counter ? "C" : "X";
+        entry["ts"] = event.start;
+        if (section.counter)
+        {
+            entry["args"].format = JsonFormat::Inline;
+            entry["args"]["value"] = event.duration;
+        }
+        else
+            entry["dur"] = event.duration;
+        entry["pid"] = 0;
+        entry["tid"] = event.thread;
+        json["traceEvents"].push_back(entry);
+    }
+    json.Save(path);
+    std::cout << "Saved " << traceEvents.size() << " trace events to " << path << '\n';
+}
+
+#endif
@@ -4,17 +4,36 @@
 
 #include "Progress.hpp"
 #include "Drawing.hpp"
+#include "Economy.hpp"
 #include "Human.hpp"
 #include "Island.hpp"
+#include "IslandOutline.hpp"
+#include "IslandRaster.hpp"
+#include "Jobs.hpp"
+#include "LandMask.hpp"
 #include "Languages.hpp"
+#include "MemoryStats.hpp"
+#include "Metrics.hpp"
 #include "Perlin.hpp"
+#include "Profiler.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
 #include "Settings.hpp"
 #include "Ship.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
 #include <ctime>
 #include <filesystem>
+#include <iostream>
+#include <raymath.h>
+
+#define SAVE_VERSION 3
 
 std::vector<SaveSlot> saveSlots(MAX_SAVE_SLOTS);
 int currentSlot = -1;
+// The copy the autosave job writes, it's only touched again after the job is done
+SaveSlot autosaveSlot;
+JobGroup autosaveJob;
 
 Json SaveSlot::ToJSON()
 {
@@ -37,6 +56,9 @@ Json SaveSlot::ToJSON()
     json["woodTotal"] = this->woodTotal;
     json["ironTotal"] = this->ironTotal;
     json["peopleTotal"] = this->peopleTotal;
+    json["saveTime"] = this->saveTime;
+    json["simulationTime"] = this->simulationTime;
+    if (!this->islandRaster.empty()) json["islandRaster"] = IslandRasterToJSON(this->islandRaster);
 
     json["mapSize"].format = JsonFormat::Inline;
     json["mapSize"].push_back(this->mapSize.x);
@@ -68,28 +90,108 @@ void SaveSlot::LoadJSON(Json& json)
     this->woodTotal = json["woodTotal"].GetInt();
     this->ironTotal = json["ironTotal"].GetInt();
     this->peopleTotal = json["peopleTotal"].GetInt();
+    this->saveTime = json["saveTime"].GetDouble();
+    this->simulationTime = json["simulationTime"].GetDouble();
+    this->islandRaster = IslandRasterFromJSON(json["islandRaster"]);
     this->mapSize = {static_cast<float>(json["mapSize"][0].GetDouble()),
                      static_cast<float>(json["mapSize"][1].GetDouble())};
 }
 
+void FillSlot(SaveSlot& slot, int idx)
+{
+    CatchUpEconomy();
+    slot.seed = perlinSeed;
+    slot.islands = islands;
+    slot.ships.clear();
+    for (size_t i = 0; i < ships.size(); i++)
+    {
+        slot.ships.push_back(ships.Get(i, simulationTime));
+    }
+    // Ships still waiting for a path are saved as arrived, like all the other ships
+    for (auto& request: shipRequests)
+    {
+        Ship ship;
+        ship.sourceIndex = request.sourceIndex;
+        ship.targetIndex = request.targetIndex;
+        ship.people = request.people;
+        ship.pos = (islands[request.sourceIndex].p1 + islands[request.sourceIndex].p2) / 2;
+        slot.ships.push_back(ship);
+    }
+    slot.people = people;
+    slot.woodTotal = woodTotal;
+    slot.ironTotal = ironTotal;
+    slot.peopleTotal = peopleTotal;
+    slot.name = labels["Slot"] + " " + std::to_string(idx + 1);
+    slot.mapSize = mapSize;
+    slot.saveTime = time(nullptr);
+    slot.simulationTime = simulationTime;
+    slot.islandRaster = islandRaster;
+}
+
 void SaveToSlot(int idx)
 {
     if (idx < 0) return;
-    saveSlots[idx].seed = perlinSeed;
-    saveSlots[idx].islands = islands;
-    saveSlots[idx].pathMap = pathMap;
-    saveSlots[idx].ships = ships;
-    saveSlots[idx].people = people;
-    saveSlots[idx].woodTotal = woodTotal;
-    saveSlots[idx].ironTotal = ironTotal;
-    saveSlots[idx].peopleTotal = peopleTotal;
-    saveSlots[idx].name = labels["Slot"] + " " + std::to_string(idx + 1);
-    saveSlots[idx].mapSize = mapSize;
+    FillSlot(saveSlots[idx], idx);
+}
+
+void Autosave()
+{
+    if (currentSlot < 0) return;
+    PROFILE_SCOPE("Autosave");
+    autosaveJob.Wait();
+    FillSlot(autosaveSlot, currentSlot);
+    autosaveJob.Run(
+        [idx = currentSlot]
+        {
+            Json json;
+            json["version"] = SAVE_VERSION;
+            json["slot"] = idx;
+            json["save"] = autosaveSlot.ToJSON();
+            try
+            {
+                json.Save(AUTOSAVE_PATH);
+            }
+            catch (const std::exception& error)
+            {
+                std::cerr << "Failed to write " << AUTOSAVE_PATH << ": " << error.what() << '\n';
+            }
+        });
+}
+
+// The slots are saved or were left without saving, either way the autosave is older than them
+void DiscardAutosave()
+{
+    autosaveJob.Wait();
+    autosaveSlot = {};
+    std::error_code error;
+    std::filesystem::remove(AUTOSAVE_PATH, error);
+}
+
+void LoadAutosave()
+{
+    if (!std::filesystem::exists(AUTOSAVE_PATH)) return;
+    try
+    {
+        Json json = Json::Load(AUTOSAVE_PATH);
+        int idx = json["slot"].GetInt();
+        if (json["version"].GetInt() != SAVE_VERSION || idx < 0 || idx >= MAX_SAVE_SLOTS) return;
+        SaveSlot slot;
+        slot.LoadJSON(json["save"]);
+        if (slot.saveTime > saveSlots[idx].saveTime) saveSlots[idx] = std::move(slot);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "Failed to load " << AUTOSAVE_PATH << ": " << error.what() << '\n';
+    }
 }
 
 void LoadFromSlot(int idx)
 {
+    PROFILE_SCOPE("Load slot");
+    // A saved world can't be built again from its seed, so only new maps are recorded
+    StopRecording();
     currentSlot = idx;
+    CancelPathMap();
     if (saveSlots[idx].seed == -1)
     {
         BuildMap();
@@ -98,44 +200,88 @@ void LoadFromSlot(int idx)
     }
 
     perlinSeed = saveSlots[idx].seed;
+    SeedRandom(perlinSeed);
     islands = saveSlots[idx].islands;
-    ships = saveSlots[idx].ships;
     people = saveSlots[idx].people;
+    RebuildPeopleIndex();
+    populationHeap.Build();
     woodTotal = saveSlots[idx].woodTotal;
     ironTotal = saveSlots[idx].ironTotal;
     peopleTotal = saveSlots[idx].peopleTotal;
     mapSize = saveSlots[idx].mapSize;
+    simulationTime = saveSlots[idx].simulationTime;
+    ResetSimulationEvents();
+    ships.Clear();
+    for (auto& ship: saveSlots[idx].ships)
+    {
+        ships.Add(ship);
+    }
+    shipRequests.clear();
 
-    auto func = [](std::string& label, float& loadingPercent, std::atomic<bool>& finished)
+    auto func = [](LoadingState& loading, int idx)
     {
-        // GeneratePathMap isn't actually using a node graph. It's just a reference
-        label = "Node graph out of date. Rebuilding...";
-        loadingPercent = 0;
-        GeneratePathMap();
-        finished = true;
+        // Runs on a worker, which draws from the main stream like the main thread would
+        Rng* lastRng = SetThreadRng(&GetRng(RngStream::Main));
+        loading.SetLabel(labels["Loading map..."]);
+        BuildLandMask();
+        ResizeIslandRaster();
+        if (saveSlots[idx].islandRaster.size() == islandRaster.size())
+            islandRaster = saveSlots[idx].islandRaster;
+        else
+            RebuildIslandRaster();
+        BuildIslandCells();
+        BuildIslandOutlines();
+
+        // Islands kept growing while the slot wasn't played
+        if (saveSlots[idx].saveTime > 0)
+        {
+            double elapsed = time(nullptr) - saveSlots[idx].saveTime;
+            if (elapsed >= GROWTH_PERIOD)
+                CatchUpOffline(saveSlots[idx].saveTime / GROWTH_PERIOD, elapsed / GROWTH_PERIOD);
+        }
+        SetThreadRng(lastRng);
     };
-    ShowLoadingScreen(false, func);
+    ShowLoadingScreen(false, func, idx);
 
-    SetShaderValue(perlinShader, GetShaderLocation(perlinShader, "uSeed"), &perlinSeed,
-                   SHADER_UNIFORM_INT);
+    // The path maps are built in the background, ships wait for them in shipRequests
+    GeneratePathMap();
 }
 
 void EmptySlot(int idx) { saveSlots[idx] = {}; }
 
 void SaveProgress()
 {
+    PROFILE_SCOPE("Save");
+    DiscardAutosave();
     SaveToSlot(currentSlot);
 
     Json json;
 
-    json["version"] = 3;
+    json["version"] = SAVE_VERSION;
 
-    for (size_t i = 0; i < MAX_SAVE_SLOTS; i++)
+    // Slots don't share anything, so they are serialized in parallel
+    json["saves"] = Json::array_t(MAX_SAVE_SLOTS);
+    Json::array_t& saves = json["saves"].GetArray();
+    ParallelFor(0, MAX_SAVE_SLOTS, 1,
+                [&saves](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        saves[i] = saveSlots[i].ToJSON();
+                    }
+                });
+    // Walking the whole document isn't free, so it's only measured when someone looks
+    if (memoryStatsEnabled)
     {
-        json["saves"].push_back(saveSlots[i].ToJSON());
+        UpdateMemoryStats();
+        SetMemoryUsage(MemorySubsystem::Json, json.MemoryUsage());
     }
 
     json.Save("saves.json");
+    std::error_code error;
+    auto bytes = std::filesystem::file_size("saves.json", error);
+    if (!error) AddMetric(Metric::SaveBytes, bytes);
+    if (memoryStatsEnabled) SetMemoryUsage(MemorySubsystem::Json, 0);
 }
 
 void MigrateV0()
@@ -179,19 +325,40 @@ void MigrateV2()
 
 void LoadProgress()
 {
+    PROFILE_SCOPE("Load");
     if (!std::filesystem::exists("saves.json"))
     {
         SaveProgress();
         return;
     }
 
-    Json json = Json::Load("saves.json");
-
-    int version = json["version"].GetInt();
-
-    for (size_t i = 0; i < json["saves"].size(); i++)
+    // A broken file leaves the slots empty instead of closing the game, it's overwritten by the
+    // next save
+    Json json;
+    int version = 0;
+    try
+    {
+        json = Json::Load("saves.json");
+        version = json["version"].GetInt();
+        if (!json["saves"].IsArray()) throw std::runtime_error("there are no saves");
+        Json::array_t& saves = json["saves"].GetArray();
+        ParallelFor(0, std::min(saves.size(), saveSlots.size()), 1,
+                    [&saves](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; i++)
+                        {
+                            saveSlots[i].LoadJSON(saves[i]);
+                        }
+                    });
+    }
+    catch (const std::exception& error)
     {
-        saveSlots[i].LoadJSON(json["saves"][i]);
+        std::cerr << "Failed to load saves.json: " << error.what() << '\n';
+        for (size_t i = 0; i < saveSlots.size(); i++)
+        {
+            EmptySlot(i);
+        }
+        return;
     }
 
     if (version == 0)
@@ -209,4 +376,11 @@ void LoadProgress()
         MigrateV2();
         version = 3;
     }
+    LoadAutosave();
+    if (memoryStatsEnabled)
+    {
+        UpdateMemoryStats();
+        SetMemoryUsage(MemorySubsystem::Json, json.MemoryUsage());
+        SetMemoryUsage(MemorySubsystem::Json, 0);
+    }
 }
@@ -0,0 +1,81 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Random.hpp"
+#include <atomic>
+
+uint64_t randomSeed = 0;
+Rng streams[(int)RngStream::Count];
+Rng worldSeedRng;
+std::atomic<uint64_t> threadCounter{0};
+
+thread_local Rng* threadRng = nullptr;
+thread_local Rng ownThreadRng;
+thread_local bool ownThreadRngSeeded = false;
+
+uint64_t SplitMix64(uint64_t& x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+Rng::Rng(uint64_t seed, uint64_t stream)
+{
+    uint64_t x = seed;
+    this->seed = SplitMix64(x) ^ (stream * 0xD1B54A32D192ED03ull);
+    x = this->seed;
+    uint64_t a = SplitMix64(x), b = SplitMix64(x);
+    state[0] = a;
+    state[1] = a >> 32;
+    state[2] = b;
+    state[3] = b >> 32;
+    if ((state[0] | state[1] | state[2] | state[3]) == 0) state[0] = 1;
+}
+
+void SeedRandom(uint64_t seed)
+{
+    randomSeed = seed;
+    for (int i = 0; i < (int)RngStream::Count; i++)
+    {
+        streams[i] = Rng(seed, i);
+    }
+    threadRng = &streams[(int)RngStream::Main];
+}
+
+uint64_t GetRandomSeed() { return randomSeed; }
+
+void SeedWorldSeeds(uint64_t seed) { worldSeedRng = Rng(seed, 0); }
+
+int GetNewWorldSeed() { return worldSeedRng.Next() >> 1; }
+
+Rng& GetRng(RngStream stream) { return streams[(int)stream]; }
+
+Rng MakeRng(RngStream stream, uint64_t chunk) { return streams[(int)stream].Split(chunk); }
+
+Rng& GetThreadRng()
+{
+    if (threadRng) return *threadRng;
+    if (!ownThreadRngSeeded)
+    {
+        ownThreadRng = Rng(randomSeed, (int)RngStream::Count + threadCounter++);
+        ownThreadRngSeeded = true;
+    }
+    return ownThreadRng;
+}
+
+Rng* SetThreadRng(Rng* rng)
+{
+    Rng* previous = threadRng;
+    threadRng = rng;
+    return previous;
+}
+
+uint32_t GetRandomAt(RngStream stream, uint64_t key, uint64_t counter)
+{
+    uint64_t x = streams[(int)stream].seed ^ (key * 0xD1B54A32D192ED03ull);
+    x = SplitMix64(x) ^ counter;
+    return SplitMix64(x) >> 32;
+}
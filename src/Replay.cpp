@@ -0,0 +1,303 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Replay.hpp"
+#include "Economy.hpp"
+#include "Human.hpp"
+#include "Island.hpp"
+#include "MemoryStats.hpp"
+#include "Metrics.hpp"
+#include "Pathfinding.hpp"
+#include "Perlin.hpp"
+#include "Progress.hpp"
+#include "Settings.hpp"
+#include "Ship.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const char* replayActionNames[] = {"colonize", "sendPeople", "taxes", "ship"};
+
+Recording recording;
+bool recordingEnabled = false;
+bool isRecording = false;
+bool isReplaying = false;
+
+Json ReplayAction::ToJSON()
+{
+    Json json;
+    json.format = JsonFormat::Inline;
+    json["time"] = time;
+    json["type"] = replayActionNames[(int)type];
+    json["island"] = island;
+    json["value"] = value;
+    if (type == ReplayActionType::Ship) json["people"] = people;
+    return json;
+}
+
+ReplayAction ReplayAction::LoadJSON(Json& json)
+{
+    ReplayAction action;
+    action.time = json["time"].GetDouble();
+    std::string type = json["type"].GetString();
+    for (int i = 0; i < (int)std::size(replayActionNames); i++)
+    {
+        if (type == replayActionNames[i]) action.type = (ReplayActionType)i;
+    }
+    action.island = json["island"].GetInt();
+    // Recordings from before the sources were recorded let the island pick it
+    action.value = json["value"].IsNull() ? -1 : json["value"].GetInt();
+    action.people = json["people"].GetInt();
+    return action;
+}
+
+Json Recording::ToJSON()
+{
+    Json json;
+    json["seed"] = seed;
+    json["mapSize"].format = JsonFormat::Inline;
+    json["mapSize"].push_back(mapSize.x);
+    json["mapSize"].push_back(mapSize.y);
+    json["endTime"] = endTime;
+    json["actions"] = Json::array_t();
+    for (auto& action: actions)
+    {
+        json["actions"].push_back(action.ToJSON());
+    }
+    return json;
+}
+
+Recording Recording::LoadJSON(Json& json)
+{
+    Recording recording;
+    recording.seed = json["seed"].GetDouble();
+    recording.mapSize = {static_cast<float>(json["mapSize"][0].GetDouble()),
+                         static_cast<float>(json["mapSize"][1].GetDouble())};
+    recording.endTime = json["endTime"].GetDouble();
+    for (size_t i = 0; i < json["actions"].size(); i++)
+    {
+        recording.actions.push_back(ReplayAction::LoadJSON(json["actions"][i]));
+    }
+    return recording;
+}
+
+void EnableRecording() { recordingEnabled = true; }
+
+void StartRecording()
+{
+    if (isReplaying || !recordingEnabled) return;
+    StopRecording();
+    recording = Recording();
+    recording.seed = perlinSeed;
+    recording.mapSize = mapSize;
+    isRecording = true;
+}
+
+void StopRecording()
+{
+    if (!isRecording) return;
+    isRecording = false;
+    recording.endTime = simulationTime;
+    recording.ToJSON().Save(RECORDING_PATH);
+}
+
+void RecordAction(ReplayActionType type, int island, int value, int people)
+{
+    if (!isRecording) return;
+    ReplayAction action;
+    action.time = simulationTime;
+    action.type = type;
+    action.island = island;
+    action.value = value;
+    action.people = people;
+    recording.actions.push_back(action);
+}
+
+bool IsReplaying() { return isReplaying; }
+
+// FNV-1a
+struct StateHash
+{
+    uint64_t value = 14695981039346656037ull;
+
+    template <typename T> void Add(const T& data)
+    {
+        unsigned char bytes[sizeof(T)];
+        memcpy(bytes, &data, sizeof(T));
+        for (unsigned char byte: bytes)
+        {
+            value = (value ^ byte) * 1099511628211ull;
+        }
+    }
+};
+
+uint64_t GetStateHash()
+{
+    StateHash hash;
+    hash.Add(simulationTime);
+    hash.Add(woodTotal);
+    hash.Add(ironTotal);
+    hash.Add(peopleTotal);
+    for (auto& island: islands)
+    {
+        hash.Add(island.woodCount);
+        hash.Add(island.ironCount);
+        hash.Add(island.peopleCount);
+        hash.Add(island.peopleMax);
+        hash.Add(island.futurePeopleCount);
+        hash.Add(island.addPeopleFraction);
+        hash.Add(island.colonizationInProgress);
+        hash.Add(island.colonized);
+        hash.Add(island.taxes);
+        hash.Add(island.efficiency);
+    }
+    for (size_t i = 0; i < ships.size(); i++)
+    {
+        hash.Add(ships.sourceIndex[i]);
+        hash.Add(ships.targetIndex[i]);
+        hash.Add(ships.people[i]);
+        hash.Add(ships.departure[i]);
+        hash.Add(ships.arrival[i]);
+    }
+    hash.Add(people.size());
+    // By island, the order of people changes when humans are removed
+    for (auto& list: islandPeople)
+    {
+        for (uint32_t idx: list)
+        {
+            hash.Add(people[idx].pos);
+        }
+    }
+    return hash.value;
+}
+
+void ApplyReplayAction(const ReplayAction& action)
+{
+    if (action.island < 0 || (size_t)action.island >= islands.size()) return;
+    // The source of the people, -1 lets the island pick it
+    int source = action.value < (int)islands.size() ? action.value : -1;
+    switch (action.type)
+    {
+    case ReplayActionType::Colonize:
+        islands[action.island].Colonize(source);
+        break;
+    case ReplayActionType::SendPeople:
+        islands[action.island].SendPeople(1, source);
+        break;
+    case ReplayActionType::Taxes:
+        CatchUpEconomy(action.island);
+        islands[action.island].taxes = action.value;
+        break;
+    case ReplayActionType::Ship:
+        if (action.value >= 0 && (size_t)action.value < islands.size())
+            ships.Launch(action.island, action.value, action.people);
+        break;
+    }
+}
+
+int RunReplay(const std::string& path, double step, const std::string& out)
+{
+    Recording replay;
+    try
+    {
+        Json json = Json::Load(path);
+        replay = Recording::LoadJSON(json);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "Failed to load the recording " << path << ": " << error.what() << '\n';
+        return 1;
+    }
+    step = std::max(step, 0.001);
+
+    isReplaying = true;
+    memoryStatsEnabled = true;
+    simulationSpeed = 1;
+    currentSlot = -1;
+    perlinSeed = replay.seed;
+    mapSize = replay.mapSize;
+
+    auto start = std::chrono::steady_clock::now(), phaseStart = start;
+    std::vector<std::pair<const char*, double>> phases;
+    auto endPhase = [&phases, &phaseStart](const char* name)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double time = std::chrono::duration<double, std::milli>(now - phaseStart).count();
+        phases.push_back({name, time});
+        phaseStart = now;
+    };
+
+    BuildMap(true);
+    endPhase("build");
+    UpdateMemoryStats();
+
+    for (size_t i = 0; i < islands.size(); i++)
+    {
+        while (!IsPathMapReady(i))
+        {
+            std::this_thread::yield();
+        }
+    }
+    endPhase("pathMap");
+    UpdateMemoryStats();
+
+    int steps = 0;
+    auto stepTo = [&steps, step, start](double time)
+    {
+        while (simulationTime < time)
+        {
+            StepSimulation(std::min(simulationTime + step, time));
+            steps++;
+            if (steps % REPLAY_MEMORY_INTERVAL == 0) UpdateMemoryStats();
+            UpdateMetrics(
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+    };
+    for (auto& action: replay.actions)
+    {
+        stepTo(action.time);
+        ApplyReplayAction(action);
+    }
+    stepTo(replay.endTime);
+    CatchUpEconomy();
+    endPhase("simulation");
+    UpdateMemoryStats();
+
+    uint64_t hash = GetStateHash();
+    isReplaying = false;
+
+    std::cout << "Replayed " << replay.actions.size() << " actions over " << simulationTime
+              << " s in " << steps << " steps\n";
+    std::cout << "State hash: " << TextFormat("%016llx", (unsigned long long)hash) << '\n';
+    for (auto& [name, time]: phases)
+    {
+        std::cout << name << ": " << time << " ms\n";
+    }
+    PrintMemoryStats();
+
+    if (!out.empty())
+    {
+        Json report;
+        report["recording"] = path;
+        report["seed"] = replay.seed;
+        report["actions"] = (int)replay.actions.size();
+        report["steps"] = steps;
+        report["simulationTime"] = simulationTime;
+        report["hash"] = TextFormat("%016llx", (unsigned long long)hash);
+        report["phasesMs"].format = JsonFormat::Inline;
+        for (auto& [name, time]: phases)
+        {
+            report["phasesMs"][name] = time;
+        }
+        report["memory"] = MemoryStatsToJSON();
+        report.Save(out);
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Scheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Scheduler scheduler;
+
+bool operator>(const ScheduledEvent& a, const ScheduledEvent& b)
+{
+    if (a.time != b.time) return a.time > b.time;
+    return a.sequence > b.sequence;
+}
+
+int64_t Scheduler::ToTick(double time) { return floor(time * SCHEDULER_RESOLUTION); }
+
+void Scheduler::Reset(double time)
+{
+    for (auto& level: slots)
+    {
+        for (auto& slot: level)
+        {
+            slot.clear();
+        }
+    }
+    std::fill(std::begin(occupied), std::end(occupied), 0);
+    overflow.clear();
+    due.clear();
+    now = ToTick(time);
+    horizon = time;
+    count = 0;
+}
+
+void Scheduler::Schedule(double time, void (*fire)(int64_t data), int64_t data)
+{
+    Insert({time, nextSequence++, fire, data});
+    count++;
+}
+
+void Scheduler::Insert(const ScheduledEvent& event)
+{
+    int64_t tick = ToTick(event.time);
+    if (tick <= now)
+    {
+        due.push_back(event);
+        std::push_heap(due.begin(), due.end(), std::greater<ScheduledEvent>());
+        return;
+    }
+
+    // The lowest level where the event is in the same turn as now
+    for (int level = 0; level < SCHEDULER_LEVELS; level++)
+    {
+        int shift = SCHEDULER_SLOT_BITS * level;
+        if ((tick >> (shift + SCHEDULER_SLOT_BITS)) != (now >> (shift + SCHEDULER_SLOT_BITS)))
+            continue;
+        int slot = (tick >> shift) & (SCHEDULER_SLOTS - 1);
+        slots[level][slot].push_back(event);
+        occupied[level] |= 1ull << slot;
+        return;
+    }
+    overflow.push_back(event);
+}
+
+uint64_t Scheduler::LaterSlots(int level) const
+{
+    int current = (now >> (SCHEDULER_SLOT_BITS * level)) & (SCHEDULER_SLOTS - 1);
+    if (current == SCHEDULER_SLOTS - 1) return 0;
+    return occupied[level] & ~((2ull << current) - 1);
+}
+
+int64_t Scheduler::NextOccupiedTick(int64_t limit) const
+{
+    int64_t next = limit;
+    for (int level = 0; level < SCHEDULER_LEVELS; level++)
+    {
+        int shift = SCHEDULER_SLOT_BITS * level;
+        uint64_t later = LaterSlots(level);
+        if (later == 0) continue;
+        int slot = __builtin_ctzll(later);
+        int64_t turn = now >> (shift + SCHEDULER_SLOT_BITS) << (shift + SCHEDULER_SLOT_BITS);
+        next = std::min(next, turn | ((int64_t)slot << shift));
+    }
+    if (!overflow.empty())
+    {
+        int shift = SCHEDULER_SLOT_BITS * SCHEDULER_LEVELS;
+        next = std::min(next, ((now >> shift) + 1) << shift);
+    }
+    return next;
+}
+
+void Scheduler::MoveTo(int64_t tick)
+{
+    now = tick;
+
+    // Events that fit in the wheel again
+    const int topShift = SCHEDULER_SLOT_BITS * SCHEDULER_LEVELS;
+    if ((now & ((1ll << topShift) - 1)) == 0 && !overflow.empty())
+    {
+        moving.clear();
+        moving.swap(overflow);
+        for (auto& event: moving)
+        {
+            Insert(event);
+        }
+    }
+
+    // Move the slots whose turn starts now one level down, the highest first
+    for (int level = SCHEDULER_LEVELS - 1; level >= 0; level--)
+    {
+        int shift = SCHEDULER_SLOT_BITS * level;
+        if (now & ((1ll << shift) - 1)) continue;
+        int slot = (now >> shift) & (SCHEDULER_SLOTS - 1);
+        if (!(occupied[level] & (1ull << slot))) continue;
+        moving.clear();
+        moving.swap(slots[level][slot]);
+        occupied[level] &= ~(1ull << slot);
+        for (auto& event: moving)
+        {
+            Insert(event);
+        }
+    }
+}
+
+void Scheduler::Advance(double& clock, double time)
+{
+    horizon = time;
+    int64_t target = ToTick(time);
+    while (true)
+    {
+        while (!due.empty() && due.front().time <= time)
+        {
+            std::pop_heap(due.begin(), due.end(), std::greater<ScheduledEvent>());
+            ScheduledEvent event = due.back();
+            due.pop_back();
+            count--;
+            clock = std::max(clock, event.time);
+            event.fire(event.data);
+        }
+        if (now >= target) break;
+        MoveTo(NextOccupiedTick(target));
+    }
+    clock = std::max(clock, time);
+}
+
+double Scheduler::NextTime() const
+{
+    double next = std::numeric_limits<double>::infinity();
+    if (!due.empty()) return due.front().time;
+
+    // The earliest event is in the next occupied slot of one of the levels
+    for (int level = 0; level < SCHEDULER_LEVELS; level++)
+    {
+        uint64_t later = LaterSlots(level);
+        if (later == 0) continue;
+        for (auto& event: slots[level][__builtin_ctzll(later)])
+        {
+            next = std::min(next, event.time);
+        }
+    }
+    for (auto& event: overflow)
+    {
+        next = std::min(next, event.time);
+    }
+    return next;
+}
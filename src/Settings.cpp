@@ -10,8 +10,12 @@
 
 bool vsync = true;
 bool showFPS = true;
+bool bakeTerrain = true;
 float panSensitivity = 500;
 float wheelSensitivity = 0.3f;
+int workerThreads = 0;
+float outlineTolerance = 0.5f;
+int metricsInterval = 0;
 Vector2 mapSize = {300, 300};
 
 std::vector<std::string> Split(std::string input, char delimiter = ' ')
@@ -37,8 +41,12 @@ void Save()
     std::ofstream file("settings.txt");
     file << "vsync=" << (vsync ? "true" : "false") << '\n';
     file << "show-fps=" << (showFPS ? "true" : "false") << '\n';
+    file << "bake-terrain=" << (bakeTerrain ? "true" : "false") << '\n';
     file << "pan-sensitivity=" << panSensitivity << '\n';
     file << "wheel-sensitivity=" << wheelSensitivity << '\n';
+    file << "worker-threads=" << workerThreads << '\n';
+    file << "outline-tolerance=" << outlineTolerance << '\n';
+    file << "metrics-interval=" << metricsInterval << '\n';
     file << "language=" << currentLanguage << '\n';
     file.close();
 }
@@ -53,8 +61,12 @@ void Load()
         value = Split(buf, '=')[1];
         if (label == "vsync") vsync = value == "true";
         if (label == "show-fps") showFPS = value == "true";
+        if (label == "bake-terrain") bakeTerrain = value == "true";
         if (label == "pan-sensitivity") panSensitivity = stof(value);
         if (label == "wheel-sensitivity") wheelSensitivity = stof(value);
+        if (label == "worker-threads") workerThreads = stoi(value);
+        if (label == "outline-tolerance") outlineTolerance = stof(value);
+        if (label == "metrics-interval") metricsInterval = stoi(value);
         if (label == "language") currentLanguage = value;
     }
     file.close();
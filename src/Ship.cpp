@@ -5,57 +5,149 @@
 
 #include "Ship.hpp"
 #include "Island.hpp"
+#include "MemoryStats.hpp"
+#include "Metrics.hpp"
 #include "Pathfinding.hpp"
-#include "Perlin.hpp"
-#include <iostream>
+#include "Replay.hpp"
+#include "Scheduler.hpp"
+#include "Simulation.hpp"
 #include <raymath.h>
 #include <vector>
 
-std::vector<Ship> ships;
+ShipFleet ships;
+std::vector<ShipRequest> shipRequests;
 
-Ship::Ship(int sourceIndex, int targetIndex, int peopleCount)
-    : sourceIndex(sourceIndex), targetIndex(targetIndex), people(peopleCount)
+void ShipArrivalEvent(int64_t shipId) { ships.Arrive(shipId); }
+
+void ShipFleet::Launch(int sourceIndex, int targetIndex, int people)
 {
-    Vector2 startPos = islands[sourceIndex].GetRandomPoint();
-    Vector2 endPos = islands[targetIndex].GetRandomPoint();
-    Vector2 dir = Vector2Normalize(endPos - startPos);
+    RecordAction(ReplayActionType::Ship, sourceIndex, targetIndex, people);
+    RouteId id = GetRoute(sourceIndex, targetIndex);
+    if (id == NO_ROUTE)
+    {
+        Cancel(sourceIndex, targetIndex, people);
+        return;
+    }
+    AddMetric(Metric::ShipsLaunched);
+    this->sourceIndex.push_back(sourceIndex);
+    this->targetIndex.push_back(targetIndex);
+    this->people.push_back(people);
+    route.push_back(id);
+    origin.push_back(routePoints[routes[id].first]);
+    departure.push_back(simulationTime);
+    Push(simulationTime + routes[id].length / SHIP_SPEED);
+}
 
-    while (path.size() <= 1)
+void ShipFleet::Cancel(int sourceIndex, int targetIndex, int people)
+{
+    Island& target = islands[targetIndex];
+    target.futurePeopleCount -= people;
+    if (target.colonizationInProgress && !target.colonized && target.futurePeopleCount <= 0)
     {
-        do
-        {
-            startPos += dir;
-        } while (GetPerlin(startPos) >= LAND_START);
-    
-        path = GetPath(startPos, targetIndex);
-        std::cout << path.size() << '\n';
+        target.colonizationInProgress = false;
+        woodTotal += target.woodColonize;
+        ironTotal += target.ironColonize;
     }
-    pos = path[0];
+    islands[sourceIndex].AddPeople(people);
+}
 
-    nextPointDir = Vector2Normalize(path[0] - pos);
+void ShipFleet::Add(const Ship& ship)
+{
+    sourceIndex.push_back(ship.sourceIndex);
+    targetIndex.push_back(ship.targetIndex);
+    people.push_back(ship.people);
+    route.push_back(NO_ROUTE);
+    origin.push_back(ship.pos);
+    departure.push_back(simulationTime);
+    Push(simulationTime);
 }
 
-void Ship::Move(float deltaTime)
+void ShipFleet::Push(double arrival)
 {
-    if (reached) return;
-    Vector2 nextPos = pos + nextPointDir * SHIP_SPEED * deltaTime;
-    if (Vector2Distance(pos, path[nextPointIdx]) > Vector2Distance(nextPos, path[nextPointIdx]))
+    uint32_t shipId = slotOfId.size();
+    if (!freeIds.empty())
     {
-        pos = nextPos;
+        shipId = freeIds.back();
+        freeIds.pop_back();
     }
     else
-    {
-        nextPointIdx++;
-        if (nextPointIdx >= path.size())
-        {
-            reached = true;
-            return;
-        }
+        slotOfId.push_back(0);
+    slotOfId[shipId] = size() - 1;
+    id.push_back(shipId);
+    this->arrival.push_back(arrival);
+    scheduler.Schedule(arrival, ShipArrivalEvent, shipId);
+}
+
+Ship ShipFleet::Get(size_t i, double time) const
+{
+    Ship ship;
+    ship.sourceIndex = sourceIndex[i];
+    ship.targetIndex = targetIndex[i];
+    ship.pos = GetPosition(i, time);
+    ship.people = people[i];
+    return ship;
+}
+
+Vector2 ShipFleet::GetPosition(size_t i, double time, int* flip) const
+{
+    if (route[i] == NO_ROUTE) return origin[i];
+    return GetRoutePoint(route[i], (time - departure[i]) * SHIP_SPEED, flip);
+}
+
+void ShipFleet::Remove(size_t i)
+{
+    freeIds.push_back(id[i]);
 
-        nextPointDir = Vector2Normalize(path[nextPointIdx] - pos);
-        if (nextPointDir.x > 0.1) flip = 1;
-        if (nextPointDir.x < -0.1) flip = -1;
+    // Move the last ship into its place
+    size_t last = size() - 1;
+    if (i != last)
+    {
+        sourceIndex[i] = sourceIndex[last];
+        targetIndex[i] = targetIndex[last];
+        people[i] = people[last];
+        route[i] = route[last];
+        origin[i] = origin[last];
+        departure[i] = departure[last];
+        arrival[i] = arrival[last];
+        id[i] = id[last];
+        slotOfId[id[i]] = i;
     }
+    sourceIndex.pop_back();
+    targetIndex.pop_back();
+    people.pop_back();
+    route.pop_back();
+    origin.pop_back();
+    departure.pop_back();
+    arrival.pop_back();
+    id.pop_back();
+}
+
+void ShipFleet::Clear()
+{
+    sourceIndex.clear();
+    targetIndex.clear();
+    people.clear();
+    route.clear();
+    origin.clear();
+    departure.clear();
+    arrival.clear();
+    id.clear();
+    slotOfId.clear();
+    freeIds.clear();
+}
+
+size_t ShipFleet::MemoryUsage() const
+{
+    return MemoryOf(sourceIndex) + MemoryOf(targetIndex) + MemoryOf(people) + MemoryOf(route) +
+           MemoryOf(origin) + MemoryOf(departure) + MemoryOf(arrival) + MemoryOf(id) +
+           MemoryOf(slotOfId) + MemoryOf(freeIds);
+}
+
+void ShipFleet::Arrive(uint32_t shipId)
+{
+    size_t i = slotOfId[shipId];
+    islands[targetIndex[i]].AddPeople(people[i]);
+    Remove(i);
 }
 
 Json Ship::ToJSON()
@@ -80,9 +172,30 @@ Ship Ship::LoadJSON(Json& json)
     ship.people = json["people"].GetInt();
     ship.pos = {static_cast<float>(json["pos"][0].GetDouble()),
                 static_cast<float>(json["pos"][1].GetDouble())};
-    ship.nextPointIdx = static_cast<size_t>(json["nextPointIdx"].GetInt());
-    ship.people = json["people"].GetInt();
-    ship.reached = true;
 
     return ship;
 }
+
+void RequestShip(int sourceIndex, int targetIndex, int peopleCount)
+{
+    // The replay launches the ships at their recorded time
+    if (IsReplaying()) return;
+    if (IsPathMapReady(targetIndex))
+        ships.Launch(sourceIndex, targetIndex, peopleCount);
+    else
+        shipRequests.push_back({sourceIndex, targetIndex, peopleCount});
+}
+
+void LaunchRequestedShips()
+{
+    for (auto it = shipRequests.begin(); it != shipRequests.end();)
+    {
+        if (!IsPathMapReady(it->targetIndex))
+        {
+            ++it;
+            continue;
+        }
+        ships.Launch(it->sourceIndex, it->targetIndex, it->people);
+        it = shipRequests.erase(it);
+    }
+}
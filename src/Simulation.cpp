@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Simulation.hpp"
+#include "Economy.hpp"
+#include "Human.hpp"
+#include "Island.hpp"
+#include "Metrics.hpp"
+#include "Profiler.hpp"
+#include "Progress.hpp"
+#include "Replay.hpp"
+#include "Scheduler.hpp"
+#include "Ship.hpp"
+#include <algorithm>
+#include <cmath>
+#include <raylib.h>
+#include <vector>
+
+int simulationSpeed = 1;
+double simulationTime = 0;
+uint64_t movementStep = 0;
+
+// Growth tick number tick happens at the end of its GROWTH_PERIOD. The ticks up to the next event
+// or the end of the frame can't be told apart, so many ticks at high speeds become due at once
+void EconomyTickEvent(int64_t tick)
+{
+    double until = std::min(scheduler.Horizon(), scheduler.NextTime());
+    int64_t lastTick = std::max<int64_t>(tick, floor(until / GROWTH_PERIOD) - 1);
+    SetEconomyTick(lastTick + 1);
+    scheduler.Schedule((lastTick + 2) * GROWTH_PERIOD, EconomyTickEvent, lastTick + 1);
+}
+
+// Real time the autosave became due, negative if it isn't
+double autosaveDue = -1;
+
+void AutosaveEvent(int64_t)
+{
+    // At high speeds the simulated period passes in moments, so the saves are spaced in real time
+    static double lastSave = 0;
+    if (currentSlot >= 0 && GetTime() - lastSave >= AUTOSAVE_MIN_INTERVAL)
+    {
+        lastSave = GetTime();
+        autosaveDue = lastSave;
+    }
+    scheduler.Schedule(simulationTime + AUTOSAVE_PERIOD, AutosaveEvent);
+}
+
+void ResetSimulationEvents()
+{
+    scheduler.Reset(simulationTime);
+    movementStep = 0;
+    autosaveDue = -1;
+    int64_t tick = floor(simulationTime / GROWTH_PERIOD);
+    ResetEconomy(tick);
+    scheduler.Schedule((tick + 1) * GROWTH_PERIOD, EconomyTickEvent, tick);
+    scheduler.Schedule(simulationTime + AUTOSAVE_PERIOD, AutosaveEvent);
+}
+
+void StepSimulation(double endTime)
+{
+    PROFILE_SCOPE("Simulation");
+    PROFILE_COUNT("Scheduled events", scheduler.size());
+    float delta = endTime - simulationTime;
+
+    // Growth ticks, ship arrivals and autosaves fire in the order of their time
+    LaunchRequestedShips();
+    scheduler.Advance(simulationTime, endTime);
+    // A due autosave has the islands run their ticks before their turn in the period, so it
+    // doesn't have to run them all in one frame. A replay runs every due tick, so the order of the
+    // humans doesn't depend on the machine
+    double phase = autosaveDue >= 0 ? 1 : simulationTime / GROWTH_PERIOD - economyTick;
+    UpdateEconomy(phase, IsReplaying() ? INFINITY : ECONOMY_FRAME_BUDGET);
+    if (autosaveDue >= 0 && (IsEconomyCaughtUp() || GetTime() - autosaveDue >= AUTOSAVE_MAX_DELAY))
+    {
+        autosaveDue = -1;
+        Autosave();
+    }
+
+    // Walking is only for show, so at high speeds people don't catch up with the whole frame
+    float walk = std::min(delta, SIMULATION_MAX_WALK);
+    int steps = ceil(walk / SIMULATION_MAX_STEP);
+    for (int i = 0; i < steps; i++)
+    {
+        MovePeople(walk / steps);
+    }
+
+    SetMetric(Metric::People, people.size());
+    SetMetric(Metric::Ships, ships.size());
+    SetMetric(Metric::ColonizedIslands,
+              std::count_if(islands.begin(), islands.end(),
+                            [](const Island& island) { return island.colonized; }));
+    SetMetric(Metric::ScheduledEvents, scheduler.size());
+}
+
+void UpdateSimulation(float frameTime)
+{
+    float delta = frameTime * simulationSpeed;
+    StepSimulation(simulationTime + delta);
+}
+
+void ChangeSimulationSpeed(int direction)
+{
+    const std::vector<int> speeds = SIMULATION_SPEEDS;
+    auto it = std::find(speeds.begin(), speeds.end(), simulationSpeed);
+    int idx = it == speeds.end() ? 0 : it - speeds.begin();
+    idx = std::clamp(idx + direction, 0, (int)speeds.size() - 1);
+    simulationSpeed = speeds[idx];
+}
@@ -0,0 +1,226 @@
+// SPDX-FileCopyrightText: 2025 SemkiShow
+//
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include "Terrain.hpp"
+#include "Drawing.hpp"
+#include "Island.hpp"
+#include "Jobs.hpp"
+#include "Metrics.hpp"
+#include "Perlin.hpp"
+#include "Settings.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <raylib.h>
+#include <raymath.h>
+#include <unordered_map>
+
+struct TerrainTile
+{
+    // Only valid once all the rows are baked
+    Texture texture = {};
+    // Pixels of a tile that is still being baked
+    Image image = {};
+    int bakedRows = 0;
+    unsigned long long lastUsedFrame = 0;
+};
+
+std::unordered_map<int64_t, TerrainTile> terrainTiles;
+int terrainSeed = -1;
+Vector2 terrainMapSize = {0, 0};
+unsigned long long terrainFrame = 0;
+
+int64_t GetTileKey(int level, int tx, int ty)
+{
+    return ((int64_t)level << 48) | ((int64_t)(tx & 0xFFFFFF) << 24) | (int64_t)(ty & 0xFFFFFF);
+}
+
+int FloorDiv(int a, int b) { return a / b - (a % b != 0 && (a < 0) != (b < 0)); }
+
+float GetTileWorldSize(int level) { return TERRAIN_BASE_TEXEL * (1 << level) * TERRAIN_TILE_SIZE; }
+
+Color GetBiomeColor(float value)
+{
+    // Same blending as applyBiomes() in Perlin.fs, including the extrapolation past a biome start
+    float color[4] = {(float)biomes[0].color.r, (float)biomes[0].color.g,
+                      (float)biomes[0].color.b, 255};
+    for (size_t i = 1; i < biomes.size(); i++)
+    {
+        if (value < biomes[i].startLevel) continue;
+        const Biome &from = biomes[i - 1], &to = biomes[i];
+        float t = (value - from.startLevel) / (to.startLevel - from.startLevel);
+        color[0] = Lerp(from.color.r, to.color.r, t);
+        color[1] = Lerp(from.color.g, to.color.g, t);
+        color[2] = Lerp(from.color.b, to.color.b, t);
+    }
+    return {(unsigned char)Clamp(color[0], 0, 255), (unsigned char)Clamp(color[1], 0, 255),
+            (unsigned char)Clamp(color[2], 0, 255), (unsigned char)color[3]};
+}
+
+void BakeTile(TerrainTile& tile, int level, int tx, int ty, double deadline)
+{
+    float texel = TERRAIN_BASE_TEXEL * (1 << level), tileSize = GetTileWorldSize(level);
+    float left = tx * tileSize, top = (ty + 1) * tileSize;
+
+    // The first image row is the top of the tile, so Y goes down while the world Y goes up
+    if (tile.image.data == nullptr)
+    {
+        tile.image = GenImageColor(TERRAIN_TILE_SIZE, TERRAIN_TILE_SIZE, BLACK);
+    }
+    Color* pixels = (Color*)tile.image.data;
+    while (tile.bakedRows < TERRAIN_TILE_SIZE && GetTime() < deadline)
+    {
+        ParallelFor(tile.bakedRows, tile.bakedRows + TERRAIN_BAKE_ROWS, 2,
+                    [=](size_t begin, size_t end)
+                    {
+                        int64_t evaluations = 0;
+                        for (size_t py = begin; py < end; py++)
+                        {
+                            for (int px = 0; px < TERRAIN_TILE_SIZE; px++)
+                            {
+                                Vector2 pos = {left + (px + 0.5f) * texel,
+                                               top - (py + 0.5f) * texel};
+                                if (!InsideMap(pos)) continue;
+                                pixels[py * TERRAIN_TILE_SIZE + px] =
+                                    GetBiomeColor(GetPerlin(pos));
+                                evaluations++;
+                            }
+                        }
+                        AddMetric(Metric::NoiseEvaluations, evaluations);
+                    });
+        tile.bakedRows += TERRAIN_BAKE_ROWS;
+    }
+    if (tile.bakedRows < TERRAIN_TILE_SIZE) return;
+
+    tile.texture = LoadTextureFromImage(tile.image);
+    UnloadImage(tile.image);
+    tile.image = {};
+    GenTextureMipmaps(&tile.texture);
+    SetTextureFilter(tile.texture, TEXTURE_FILTER_TRILINEAR);
+}
+
+void BakeTiles(int level, int minX, int maxX, int minY, int maxY, double deadline)
+{
+    // The coarsest level goes first, so there is something to fall back to as soon as possible
+    for (int l: {TERRAIN_LEVELS - 1, level})
+    {
+        int parts = 1 << (l - level);
+        for (int ty = FloorDiv(minY, parts); ty <= FloorDiv(maxY, parts); ty++)
+        {
+            for (int tx = FloorDiv(minX, parts); tx <= FloorDiv(maxX, parts); tx++)
+            {
+                TerrainTile& tile = terrainTiles[GetTileKey(l, tx, ty)];
+                tile.lastUsedFrame = terrainFrame;
+                if (tile.texture.id == 0 && GetTime() < deadline)
+                {
+                    BakeTile(tile, l, tx, ty, deadline);
+                }
+            }
+        }
+    }
+}
+
+void DrawTile(int level, int tx, int ty)
+{
+    // Use the tile itself if it's ready, otherwise the part of the closest coarser tile covering it
+    for (int l = level; l < TERRAIN_LEVELS; l++)
+    {
+        int parts = 1 << (l - level);
+        int ax = FloorDiv(tx, parts), ay = FloorDiv(ty, parts);
+        int64_t key = GetTileKey(l, ax, ay);
+
+        auto it = terrainTiles.find(key);
+        if (it == terrainTiles.end() || it->second.texture.id == 0) continue;
+        it->second.lastUsedFrame = terrainFrame;
+
+        float partSize = (float)TERRAIN_TILE_SIZE / parts;
+        Rectangle source = {(tx - ax * parts) * partSize,
+                            (parts - 1 - (ty - ay * parts)) * partSize, partSize, partSize};
+
+        float tileSize = GetTileWorldSize(level);
+        Vector2 topLeft = GlslToRaylib({tx * tileSize, (ty + 1) * tileSize});
+        Vector2 bottomRight = GlslToRaylib({(tx + 1) * tileSize, ty * tileSize});
+        DrawTexturePro(it->second.texture, source,
+                       {topLeft.x, topLeft.y, bottomRight.x - topLeft.x, bottomRight.y - topLeft.y},
+                       {0, 0}, 0, WHITE);
+        return;
+    }
+}
+
+void EvictTiles()
+{
+    while (terrainTiles.size() > TERRAIN_MAX_TILES)
+    {
+        auto oldest = terrainTiles.begin();
+        for (auto it = terrainTiles.begin(); it != terrainTiles.end(); it++)
+        {
+            if (it->second.lastUsedFrame < oldest->second.lastUsedFrame) oldest = it;
+        }
+        if (oldest->second.lastUsedFrame == terrainFrame) return;
+        UnloadTexture(oldest->second.texture);
+        UnloadImage(oldest->second.image);
+        terrainTiles.erase(oldest);
+    }
+}
+
+void DrawTerrain()
+{
+    if (terrainSeed != perlinSeed || terrainMapSize.x != mapSize.x ||
+        terrainMapSize.y != mapSize.y)
+    {
+        ClearTerrainCache();
+        terrainSeed = perlinSeed;
+        terrainMapSize = mapSize;
+    }
+    terrainFrame++;
+
+    // Pick the level with 1-2 texels per screen pixel
+    float unitsPerPixel = fmaxf(perlinScale * GetWindowScaleDPI().x, TERRAIN_BASE_TEXEL);
+    int level = floorf(log2f(unitsPerPixel / TERRAIN_BASE_TEXEL));
+    level = std::clamp(level, 0, TERRAIN_LEVELS - 1);
+
+    // Visible part of the map
+    Vector2 corner1 = RaylibToGlsl({0, 0}), corner2 = RaylibToGlsl(windowSize);
+    Vector2 minPos = {fmaxf(fminf(corner1.x, corner2.x), -mapSize.x / 2),
+                      fmaxf(fminf(corner1.y, corner2.y), -mapSize.y / 2)};
+    Vector2 maxPos = {fminf(fmaxf(corner1.x, corner2.x), mapSize.x / 2),
+                      fminf(fmaxf(corner1.y, corner2.y), mapSize.y / 2)};
+    if (minPos.x >= maxPos.x || minPos.y >= maxPos.y) return;
+
+    float tileSize = GetTileWorldSize(level);
+    int minX = floorf(minPos.x / tileSize), maxX = floorf(maxPos.x / tileSize);
+    int minY = floorf(minPos.y / tileSize), maxY = floorf(maxPos.y / tileSize);
+
+    BakeTiles(level, minX, maxX, minY, maxY, GetTime() + TERRAIN_BAKE_BUDGET);
+    for (int ty = minY; ty <= maxY; ty++)
+    {
+        for (int tx = minX; tx <= maxX; tx++)
+        {
+            DrawTile(level, tx, ty);
+        }
+    }
+
+    EvictTiles();
+}
+
+void ClearTerrainCache()
+{
+    for (auto& [key, tile]: terrainTiles)
+    {
+        UnloadTexture(tile.texture);
+        UnloadImage(tile.image);
+    }
+    terrainTiles.clear();
+}
+
+size_t GetTerrainMemory()
+{
+    size_t bytes = 0;
+    for (auto& [key, tile]: terrainTiles)
+    {
+        bytes += GetPixelDataSize(tile.texture.width, tile.texture.height, tile.texture.format);
+        bytes += GetPixelDataSize(tile.image.width, tile.image.height, tile.image.format);
+    }
+    return bytes;
+}
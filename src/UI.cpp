@@ -6,14 +6,20 @@
 #include "UI.hpp"
 #include "Drawing.hpp"
 #include "Drawing/GameMenu.hpp"
+#include "Economy.hpp"
 #include "Island.hpp"
+#include "IslandOutline.hpp"
 #include "Languages.hpp"
 #include "Perlin.hpp"
 #include "Progress.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
 #include "Settings.hpp"
+#include "Simulation.hpp"
 #include <raygui.h>
 #include <raylib.h>
 #include <string>
+#include <thread>
 
 bool showIslandsBoxes = false;
 
@@ -45,6 +51,8 @@ int slotSeed = -1;
 bool squareMap = true;
 Vector2 slotMapSize{300, 300};
 int islandEditIdx = -1;
+// The outline tolerance was dragged, the outlines are rebuilt once the slider is let go
+bool outlinesOutdated = false;
 
 void DrawCheckBox(const char* text, bool* value)
 {
@@ -58,7 +66,7 @@ void DrawSlider(const char* leftText, const char* rightText, float* value, float
 {
     GuiSlider({UI_SPACING * 2, nextElementPositionY, SLIDER_WIDTH, ELEMENT_SIZE}, leftText,
               rightText, value, minValue, maxValue);
-    DrawTextCustom(std::to_string(*value).c_str(),
+    DrawTextCustom(TextFormat("%f", *value),
                    {(SLIDER_WIDTH + UI_SPACING * 2) / 2.f, nextElementPositionY + TEXT_OFFSET},
                    ELEMENT_SIZE - 5, WHITE);
     nextElementPositionY += ELEMENT_SIZE + ELEMENT_SPACING;
@@ -71,7 +79,7 @@ void DrawSliderInt(const char* leftText, const char* rightText, int* value, floa
     GuiSlider({UI_SPACING * 2, nextElementPositionY, SLIDER_WIDTH, ELEMENT_SIZE}, leftText,
               rightText, &valueFloat, minValue, maxValue);
     *value = valueFloat;
-    DrawTextCustom(std::to_string(*value).c_str(),
+    DrawTextCustom(TextFormat("%d", *value),
                    {(SLIDER_WIDTH + UI_SPACING * 2) / 2.f, nextElementPositionY + TEXT_OFFSET},
                    ELEMENT_SIZE - TEXT_OFFSET, WHITE);
     nextElementPositionY += ELEMENT_SIZE + ELEMENT_SPACING;
@@ -116,7 +124,7 @@ void DrawLanguageButtons(float posX)
         }
         posX += ELEMENT_SIZE + ELEMENT_SPACING;
     }
-    DrawTextCustom(labels["language"].c_str(), {posX, nextElementPositionY},
+    DrawTextCustom(GetLabel("language"), {posX, nextElementPositionY},
                    ELEMENT_SIZE - TEXT_OFFSET, WHITE);
 }
 
@@ -127,10 +135,30 @@ void DrawSettings()
     DrawRectangleRounded(rec, 0.1f, 1, MENU_BACKGROUND);
     nextElementPositionY = rec.y + UI_SPACING;
 
-    DrawCheckBox(labels["vsync"].c_str(), &vsync);
-    DrawCheckBox(labels["show-fps"].c_str(), &showFPS);
-    DrawSlider("", labels["pan-sensitivity"].c_str(), &panSensitivity, 100, 1000);
-    DrawSlider("", labels["wheel-sensitivity"].c_str(), &wheelSensitivity, 0.05f, 10);
+    DrawCheckBox(GetLabel("vsync"), &vsync);
+    DrawCheckBox(GetLabel("show-fps"), &showFPS);
+    DrawCheckBox(GetLabel("bake-terrain"), &bakeTerrain);
+    DrawSlider("", GetLabel("pan-sensitivity"), &panSensitivity, 100, 1000);
+    DrawSlider("", GetLabel("wheel-sensitivity"), &wheelSensitivity, 0.05f, 10);
+    {
+        // The workers are only started once, with the value the game was started with
+        static const int startWorkerThreads = workerThreads;
+        const char* label = GetLabel("worker-threads");
+        if (workerThreads != startWorkerThreads)
+            label = TextFormat("%s (%s)", label, GetLabel("applies after a restart"));
+        DrawSliderInt("", label, &workerThreads, 0, std::thread::hardware_concurrency());
+    }
+    {
+        float lastTolerance = outlineTolerance;
+        DrawSlider("", GetLabel("outline-tolerance"), &outlineTolerance, 0, 2);
+        if (outlineTolerance != lastTolerance) outlinesOutdated = true;
+        if (outlinesOutdated && !IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+        {
+            outlinesOutdated = false;
+            if (currentSlot >= 0) BuildIslandOutlines();
+        }
+    }
+    DrawSliderInt("", GetLabel("metrics-interval"), &metricsInterval, 0, 60);
     DrawLanguageButtons(rec.x + UI_SPACING);
 
     {
@@ -149,10 +177,10 @@ void DrawAbout()
     DrawRectangleRounded(rec, 0.1f, 1, MENU_BACKGROUND);
     nextElementPositionY = rec.y + UI_SPACING;
 
-    DrawTextCentered(labels["Colony Simulator"].c_str(), 64);
-    DrawTextCentered(labels["Lead Developer: SemkiShow"].c_str(), 32);
-    DrawTextCentered(labels["Developer: jaraslauzaitsau"].c_str(), 32);
-    DrawTextCentered(labels["This game is licensed under GPL v3.0"].c_str(), 24);
+    DrawTextCentered(GetLabel("Colony Simulator"), 64);
+    DrawTextCentered(GetLabel("Lead Developer: SemkiShow"), 32);
+    DrawTextCentered(GetLabel("Developer: jaraslauzaitsau"), 32);
+    DrawTextCentered(GetLabel("This game is licensed under GPL v3.0"), 24);
 
     {
         auto buttonRec = rec;
@@ -178,7 +206,7 @@ void DrawLoadMap()
             if (GuiButton({posX, nextElementPositionY, BUTTON_SIZE, BUTTON_SIZE}, "+"))
             {
                 newMapSlot = i;
-                slotSeed = rand();
+                slotSeed = GetNewWorldSeed();
                 squareMap = true;
                 slotMapSize = {300, 300};
                 isNewWorld = true;
@@ -217,11 +245,10 @@ void DrawLoadMap()
 
     if (isEmptySlot)
     {
-        int res = GuiMessageBox(rec, labels["Warning"].c_str(),
-                                (labels["Are you sure you want to empty"] + " " +
-                                 std::string(saveSlots[slotToEmpty].name) + "?")
-                                    .c_str(),
-                                labels["Yes;No"].c_str());
+        int res = GuiMessageBox(rec, GetLabel("Warning"),
+                                TextFormat("%s %s?", GetLabel("Are you sure you want to empty"),
+                                           saveSlots[slotToEmpty].name.c_str()),
+                                GetLabel("Yes;No"));
         if (res >= 0)
         {
             if (res == 1) EmptySlot(slotToEmpty);
@@ -251,7 +278,11 @@ void EditIsland()
     }
 
     auto& island = islands[islandEditIdx];
-    DrawSliderInt("", labels["Taxes"].c_str(), &island.taxes, 0, 100);
+    // The due ticks still use the old taxes
+    CatchUpEconomy(islandEditIdx);
+    int taxes = island.taxes;
+    DrawSliderInt("", GetLabel("Taxes"), &island.taxes, 0, 100);
+    if (island.taxes != taxes) RecordAction(ReplayActionType::Taxes, islandEditIdx, island.taxes);
 }
 
 void DrawGameUI()
@@ -261,6 +292,15 @@ void DrawGameUI()
     if (GuiButton(Rectangle{windowSize.x - ELEMENT_SIZE, 0, ELEMENT_SIZE, ELEMENT_SIZE}, "#142#"))
         isSettings = !isSettings;
 
+    // Left click speeds the simulation up, right click slows it down
+    {
+        Rectangle speedRec = {windowSize.x - ELEMENT_SIZE * 4, 0, ELEMENT_SIZE * 2, ELEMENT_SIZE};
+        if (GuiButton(speedRec, TextFormat("x%d", simulationSpeed))) ChangeSimulationSpeed(1);
+        if (CheckCollisionPointRec(GetMousePosition(), speedRec) &&
+            IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
+            ChangeSimulationSpeed(-1);
+    }
+
     // if (GuiButton(Rectangle{windowSize.x - ELEMENT_SIZE * 2, 0, ELEMENT_SIZE, ELEMENT_SIZE},
     //               "#140#"))
     //     showIslandsBoxes = !showIslandsBoxes;
@@ -279,13 +319,15 @@ void DrawNewWorld()
 
     Vector2 lastMapSize = slotMapSize;
 
-    DrawValueBox(labels["seed"].c_str(), &slotSeed, 0, 100);
-    DrawCheckBox(labels["square map"].c_str(), &squareMap);
-    DrawSlider("", labels["map size x"].c_str(), &slotMapSize.x, 50, 1000);
-    DrawSlider("", labels["map size y"].c_str(), &slotMapSize.y, 50, 1000);
-    if (DrawButtonCentered(labels["Create map"].c_str()))
+    DrawValueBox(GetLabel("seed"), &slotSeed, 0, 100);
+    DrawCheckBox(GetLabel("square map"), &squareMap);
+    DrawSlider("", GetLabel("map size x"), &slotMapSize.x, 50, 1000);
+    DrawSlider("", GetLabel("map size y"), &slotMapSize.y, 50, 1000);
+    if (DrawButtonCentered(GetLabel("Create map")))
     {
         isNewWorld = false;
+        // The path map jobs of the last world read the map size
+        CancelPathMap();
         perlinSeed = slotSeed;
         mapSize = slotMapSize;
         BuildMap();
@@ -313,12 +355,12 @@ void DrawMainUI()
 
     nextElementPositionY = UI_SPACING;
 
-    DrawTextCentered(labels["Colony Simulator"].c_str(), 48);
+    DrawTextCentered(GetLabel("Colony Simulator"), 48);
     nextElementPositionY += (ELEMENT_SIZE + ELEMENT_SPACING) * 2 * windowSize.y / startWindowSize.y;
-    if (DrawButtonCentered(labels["Play"].c_str())) isLoadMap = true;
-    if (DrawButtonCentered(labels["Settings"].c_str())) isSettings = true;
-    if (DrawButtonCentered(labels["About"].c_str())) isAbout = true;
-    if (DrawButtonCentered(labels["Exit"].c_str())) shouldClose = true;
+    if (DrawButtonCentered(GetLabel("Play"))) isLoadMap = true;
+    if (DrawButtonCentered(GetLabel("Settings"))) isSettings = true;
+    if (DrawButtonCentered(GetLabel("About"))) isAbout = true;
+    if (DrawButtonCentered(GetLabel("Exit"))) shouldClose = true;
 
     if (isSettings)
         DrawSettings();
@@ -342,15 +384,15 @@ void DrawPauseUI()
                      windowSize.y - UI_SPACING * 2};
     DrawRectangleRounded(rec, 0.1f, 1, MENU_BACKGROUND);
     nextElementPositionY = rec.y + UI_SPACING;
-    if (DrawButtonCentered(labels["Return to game"].c_str())) OpenGameMenu();
-    if (DrawButtonCentered(labels["Save game"].c_str())) SaveProgress();
-    if (DrawButtonCentered(labels["Go to the main menu"].c_str())) isSaveGame = true;
+    if (DrawButtonCentered(GetLabel("Return to game"))) OpenGameMenu();
+    if (DrawButtonCentered(GetLabel("Save game"))) SaveProgress();
+    if (DrawButtonCentered(GetLabel("Go to the main menu"))) isSaveGame = true;
 
     if (isSaveGame)
     {
-        int res = GuiMessageBox(rec, labels["Info"].c_str(),
-                                labels["Would you like to save the game before exiting?"].c_str(),
-                                labels["Yes;No"].c_str());
+        int res = GuiMessageBox(rec, GetLabel("Info"),
+                                GetLabel("Would you like to save the game before exiting?"),
+                                GetLabel("Yes;No"));
         if (res >= 0)
         {
             if (res != 1) LoadFromSlot(currentSlot);
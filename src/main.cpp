@@ -4,15 +4,49 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include "Drawing.hpp"
+#include "Jobs.hpp"
 #include "Languages.hpp"
 #include "Progress.hpp"
+#include "Random.hpp"
+#include "Replay.hpp"
 #include "Settings.hpp"
+#include <cstdlib>
 #include <ctime>
 #include <raygui.h>
+#include <string>
 
-int main()
+// Plays a recording without a window: --replay path [--step seconds] [--out path]
+int RunHeadless(int argc, char** argv)
 {
-    srand(time(0));
+    std::string path, out;
+    double step = REPLAY_STEP;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--replay") path = argv[i + 1];
+        if (arg == "--step") step = atof(argv[i + 1]);
+        if (arg == "--out") out = argv[i + 1];
+    }
+
+    Load();
+    InitJobs(workerThreads);
+    int result = RunReplay(path, step, out);
+    CancelPathMap();
+    ShutdownJobs();
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--replay") return RunHeadless(argc, argv);
+        // Records every new map to RECORDING_PATH
+        if (std::string(argv[i]) == "--record") EnableRecording();
+    }
+
+    SeedRandom(time(0));
+    SeedWorldSeeds(time(0));
 
     int flags = 0;
     if (vsync) flags |= FLAG_VSYNC_HINT;
@@ -28,15 +62,14 @@ int main()
     GuiSetFont(GetFontDefault());
 
     Load();
+    InitJobs(workerThreads);
     InitGPU();
 
     {
-        auto func = [](std::string& label, float& loadingPercent, std::atomic<bool>& finished)
+        auto func = [](LoadingState& loading)
         {
-            label = labels["Loading progress..."];
-            loadingPercent = 0;
+            loading.SetLabel(labels["Loading progress..."]);
             LoadProgress();
-            finished = true;
         };
         ShowLoadingScreen(false, func);
     }
@@ -49,17 +82,18 @@ int main()
         DrawFrame();
     }
 
+    StopRecording();
     {
-        auto func = [](std::string& label, float& loadingPercent, std::atomic<bool>& finished)
+        auto func = [](LoadingState& loading)
         {
-            label = labels["Saving progress..."];
-            loadingPercent = 0;
+            loading.SetLabel(labels["Saving progress..."]);
             Save();
             SaveProgress();
-            finished = true;
         };
         ShowLoadingScreen(false, func);
     }
+    CancelPathMap();
+    ShutdownJobs();
     FreeResources();
     CloseWindow();
 